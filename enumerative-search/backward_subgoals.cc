@@ -0,0 +1,183 @@
+#include "backward_subgoals.h"
+#include "datum.h"
+#include "io_set.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include <algorithm>
+#include <climits>
+
+
+BackwardSubgoals::BackwardSubgoals(const RankedOpTable *table, IOSet *io, int max_steps) :
+  table_(table), has_multiset_(false)
+{
+  Subgoal outputs;
+  outputs.type = io->GetOutput(0)->Type();
+  outputs.multiset = false;
+  outputs.steps = 0;
+  outputs.op_id = -1;
+  outputs.parent = -1;
+  for (int i = 0; i < io->Size(); i++)  outputs.values.push_back(Values(io->GetOutput(i)));
+  Add(outputs);
+
+  // Breadth first, so every subgoal is reached by its fewest steps.
+  for (int i = 0; i < subgoals_.size() && subgoals_.size() < kMaxSubgoals; i++) {
+    if (subgoals_[i].steps >= max_steps)  continue;
+    for (auto &op : table->Successors()) {
+      Subgoal subgoal;
+      if (!Invert(subgoals_[i], op, subgoal))  continue;
+      subgoal.steps = subgoals_[i].steps + 1;
+      subgoal.op_id = op.Id();
+      subgoal.parent = i;
+      Add(subgoal);
+    }
+  }
+}
+
+
+int BackwardSubgoals::Size() const {
+  return subgoals_.size();
+}
+
+
+vector<int> BackwardSubgoals::Values(Datum *d) {
+  if (d->Type() == Int)  return vector<int>(1, d->GetIntValue());
+  return *d->GetValues();
+}
+
+
+// FNV-1a over the values of all examples.
+uint64_t BackwardSubgoals::Hash(DatumType type, const vector<vector<int> > &values) {
+  uint64_t hash = 14695981039346656037ULL;
+  auto mix = [&hash](uint32_t x) {
+    for (int b = 0; b < 4; b++) {
+      hash ^= (x >> (8 * b)) & 0xff;
+      hash *= 1099511628211ULL;
+    }
+  };
+  mix(type);
+  for (auto &example : values) {
+    mix(example.size());
+    for (int v : example)  mix(v);
+  }
+  return hash;
+}
+
+
+void BackwardSubgoals::Add(const Subgoal &subgoal) {
+  uint64_t hash = Hash(subgoal.type, subgoal.values);
+  auto range = by_hash_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    const Subgoal &other = subgoals_[it->second];
+    if (other.multiset == subgoal.multiset && other.values == subgoal.values)  return;
+  }
+  by_hash_.insert(make_pair(hash, (int) subgoals_.size()));
+  subgoals_.push_back(subgoal);
+  has_multiset_ = has_multiset_ || subgoal.multiset;
+}
+
+
+// Computes a subgoal whose image under op is subgoal, if there is one.
+bool BackwardSubgoals::Invert(const Subgoal &subgoal, const Successor &op, Subgoal &result) const {
+  if (!op.IsOp1() || op.ResultType() != subgoal.type || op.GetOp1ArgType() != subgoal.type) {
+    return false;
+  }
+  string name = op.Name();
+  result.type = subgoal.type;
+  result.multiset = subgoal.multiset;
+  result.values = subgoal.values;
+
+  if (name == "reverse") {
+    // Reversing doesn't change a multiset, so it would only add a step.
+    if (subgoal.multiset)  return false;
+    for (auto &example : result.values)  reverse(example.begin(), example.end());
+
+  } else if (name == "sort") {
+    if (subgoal.multiset)  return false;
+    for (auto &example : result.values) {
+      if (!is_sorted(example.begin(), example.end()))  return false;
+    }
+    result.multiset = true;
+
+  } else if (name == "map_negate") {
+    for (auto &example : result.values) {
+      for (auto &v : example) {
+        if (v == INT_MIN)  return false;
+        v = -v;
+      }
+    }
+
+  } else if (name == "map_increment" || name == "increment" ||
+             name == "map_decrement" || name == "decrement") {
+    int delta = (name == "map_increment" || name == "increment") ? -1 : 1;
+    for (auto &example : result.values) {
+      for (auto &v : example) {
+        if ((delta < 0 && v == INT_MIN) || (delta > 0 && v == INT_MAX))  return false;
+        v += delta;
+      }
+    }
+
+  } else if (name.compare(0, 8, "map_mult") == 0) {
+    int k = atoi(name.c_str() + 8);
+    if (k <= 0)  return false;
+    for (auto &example : result.values) {
+      for (auto &v : example) {
+        if (v % k != 0)  return false;
+        v /= k;
+      }
+    }
+
+  } else if (name == "scanl_add") {
+    if (subgoal.multiset)  return false;
+    for (int i = 0; i < result.values.size(); i++) {
+      const vector<int> &sums = subgoal.values[i];
+      for (int j = 1; j < sums.size(); j++) {
+        int64_t difference = (int64_t) sums[j] - sums[j - 1];
+        if (difference < INT_MIN || difference > INT_MAX)  return false;
+        result.values[i][j] = difference;
+      }
+    }
+
+  } else {
+    return false;
+  }
+
+  // Multisets are kept sorted, so that equal multisets compare equal.
+  if (result.multiset) {
+    for (auto &example : result.values)  sort(example.begin(), example.end());
+  }
+  return true;
+}
+
+
+int BackwardSubgoals::Match(IOSet *io, int reg, int max_steps) const {
+  DatumType type = io->GetInputs(0)->GetDatumType(reg);
+  vector<vector<int> > values;
+  for (int i = 0; i < io->Size(); i++)  values.push_back(Values(io->GetInputs(i)->GetDatum(reg)));
+
+  for (int multiset = 0; multiset <= (has_multiset_ && type == Array ? 1 : 0); multiset++) {
+    if (multiset) {
+      for (auto &example : values)  sort(example.begin(), example.end());
+    }
+    auto range = by_hash_.equal_range(Hash(type, values));
+    for (auto it = range.first; it != range.second; ++it) {
+      const Subgoal &subgoal = subgoals_[it->second];
+      if (subgoal.multiset == (multiset == 1) && subgoal.type == type &&
+          subgoal.steps <= max_steps && subgoal.values == values) {
+        return it->second;
+      }
+    }
+  }
+  return -1;
+}
+
+
+vector<Successor> BackwardSubgoals::Completion(int idx, int reg, int num_registers) const {
+  vector<Successor> result;
+  for (int i = idx; subgoals_[i].parent != -1; i = subgoals_[i].parent) {
+    Successor successor = table_->Op(subgoals_[i].op_id);
+    // Every statement after the first reads the result of the one before.
+    successor.SetOp1Arg(result.empty() ? reg : num_registers + result.size() - 1);
+    result.push_back(successor);
+  }
+  return result;
+}
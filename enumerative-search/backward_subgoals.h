@@ -0,0 +1,68 @@
+#ifndef _BACKWARD_SUBGOALS__
+#define _BACKWARD_SUBGOALS__
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "definitions.h"
+#include "successor.h"
+
+class IOSet;
+class RankedOpTable;
+
+using namespace std;
+
+class BackwardSubgoals {
+  /*
+   * BackwardSubgoals grows intermediate targets backward from the outputs
+   * of an IOSet through ops whose preimages are easy to compute: reverse,
+   * map_negate, map_increment, map_decrement, map_mult* (when every element
+   * is divisible), scanl_add (by taking differences) and sort (whose
+   * preimage is any permutation, so those subgoals only fix the multiset
+   * of elements). A register of a forward search that matches a subgoal on
+   * every example completes to a solution by applying the subgoal's ops.
+   *
+   * Subgoals are looked up by a hash of the register over all examples.
+   * Only ops in the table's ranked list are inverted.
+   */
+ public:
+  BackwardSubgoals(const RankedOpTable *table, IOSet *io, int max_steps);
+
+  int Size() const;
+
+  // Index of a subgoal that register reg of io matches on every example
+  // and that is at most max_steps away from the outputs, or -1.
+  int Match(IOSet *io, int reg, int max_steps) const;
+
+  // The statements that turn register reg, matching subgoal idx, into the
+  // outputs, when num_registers registers are in use.
+  vector<Successor> Completion(int idx, int reg, int num_registers) const;
+
+  static const int kMaxSubgoals = 10000;
+
+ protected:
+  struct Subgoal {
+    DatumType type;
+    // Values per example; sorted if multiset.
+    vector<vector<int> > values;
+    bool multiset;
+    int steps;
+    // The op applied to this subgoal yields subgoal parent.
+    int op_id;
+    int parent;
+  };
+
+  void Add(const Subgoal &subgoal);
+  bool Invert(const Subgoal &subgoal, const Successor &op, Subgoal &result) const;
+  static uint64_t Hash(DatumType type, const vector<vector<int> > &values);
+  static vector<int> Values(Datum *d);
+
+  const RankedOpTable *table_;
+  vector<Subgoal> subgoals_;
+  unordered_multimap<uint64_t, int> by_hash_;
+  bool has_multiset_;
+};
+
+#endif
@@ -0,0 +1,232 @@
+// Microbenchmarks for the op kernels in ops.cc.
+//
+// Every op is timed on random arguments for each of the requested array
+// lengths, and reported as ns per call and ns per array element. Results
+// can be saved as a baseline and later compared against, flagging ops
+// that got slower by more than a threshold.
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+#include "utils.h"
+#include "datum.h"
+#include "ops.h"
+#include "ranked_op_table.h"
+
+
+using namespace std;
+
+
+struct BenchConfig {
+  BenchConfig() :
+    lengths({1, 10, 100, 1000}), value_range(256), min_secs(0.05), repetitions(3),
+    threshold(0.1), seed(0)
+  {}
+
+  vector<int> lengths;
+  int value_range;
+  double min_secs;
+  int repetitions;
+  double threshold;
+  string filter;
+  string save_filename;
+  string baseline_filename;
+  int seed;
+};
+
+
+// Number of distinct argument sets cycled through, so that the branch
+// predictor can't learn a single input.
+static const int kNumArgSets = 64;
+
+
+static void Usage() {
+  cout << "Usage:" << endl;
+  cout << "  ops_bench [OPTIONS]" << endl;
+  cout << "Options:" << endl;
+  cout << "  --lengths=L1,L2,...  array lengths to time (default 1,10,100,1000)" << endl;
+  cout << "  --value_range=V      array values are drawn from [-V, V) (default 256)" << endl;
+  cout << "  --min_secs=S         minimum timed duration per measurement (default 0.05)" << endl;
+  cout << "  --repetitions=R      measurements per op and length; the fastest is kept (default 3)" << endl;
+  cout << "  --filter=SUBSTRING   only time ops whose name contains SUBSTRING" << endl;
+  cout << "  --seed=N             random seed (default 0)" << endl;
+  cout << "  --save=FILE          save the results as a baseline" << endl;
+  cout << "  --baseline=FILE      compare against a saved baseline" << endl;
+  cout << "  --threshold=T        relative slowdown reported as regression (default 0.1)" << endl;
+  exit(1);
+}
+
+
+static BenchConfig ParseArgs(int argc, char *argv[]) {
+  BenchConfig config;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == string::npos)  Usage();
+    string name = arg.substr(2, eq - 2);
+    string value = arg.substr(eq + 1);
+
+    if (name == "lengths") {
+      config.lengths.clear();
+      stringstream ss(value);
+      string length;
+      while (getline(ss, length, ','))  config.lengths.push_back(atoi(length.c_str()));
+    } else if (name == "value_range") {
+      config.value_range = atoi(value.c_str());
+    } else if (name == "min_secs") {
+      config.min_secs = atof(value.c_str());
+    } else if (name == "repetitions") {
+      config.repetitions = atoi(value.c_str());
+    } else if (name == "filter") {
+      config.filter = value;
+    } else if (name == "seed") {
+      config.seed = atoi(value.c_str());
+    } else if (name == "save") {
+      config.save_filename = value;
+    } else if (name == "baseline") {
+      config.baseline_filename = value;
+    } else if (name == "threshold") {
+      config.threshold = atof(value.c_str());
+    } else {
+      Usage();
+    }
+  }
+  return config;
+}
+
+
+static Datum *RandomArgument(DatumType type, int length, int value_range, mt19937 &rng) {
+  if (type == Int) {
+    // Int arguments of the search DSL are mostly indices and counts.
+    uniform_int_distribution<int> index(0, length);
+    return new Datum(index(rng));
+  }
+  uniform_int_distribution<int> value(-value_range, value_range - 1);
+  vector<int> values(length);
+  for (auto &v : values)  v = value(rng);
+  return new Datum(values);
+}
+
+
+// Returns the fastest of config.repetitions measurements of ns per call.
+static double TimeOp(const Successor &op, int length, const BenchConfig &config, mt19937 &rng) {
+  vector<Datum *> args1, args2;
+  for (int i = 0; i < kNumArgSets; i++) {
+    if (op.IsOp1()) {
+      args1.push_back(RandomArgument(op.GetOp1ArgType(), length, config.value_range, rng));
+    } else {
+      args1.push_back(RandomArgument(op.GetOp2Arg1Type(), length, config.value_range, rng));
+      args2.push_back(RandomArgument(op.GetOp2Arg2Type(), length, config.value_range, rng));
+    }
+  }
+  Datum result;
+
+  double best_ns = 0;
+  for (int rep = 0; rep < config.repetitions; rep++) {
+    long num_calls = 0;
+    long batch = kNumArgSets;
+    double secs = 0;
+    auto start = chrono::steady_clock::now();
+    while (secs < config.min_secs) {
+      for (long i = 0; i < batch; i++) {
+        int k = i % kNumArgSets;
+        if (op.IsOp1()) {
+          op.GetOp1()(args1[k], &result);
+        } else {
+          op.GetOp2()(args1[k], args2[k], &result);
+        }
+      }
+      num_calls += batch;
+      batch *= 2;
+      secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    double ns = secs * 1e9 / num_calls;
+    if (rep == 0 || ns < best_ns)  best_ns = ns;
+  }
+
+  for (auto &d : args1)  delete d;
+  for (auto &d : args2)  delete d;
+  return best_ns;
+}
+
+
+static map<pair<string, int>, double> LoadBaseline(string filename) {
+  ifstream f;
+  f.open(filename);
+  CHECK(f.is_open(), "Failed to open file " + filename);
+
+  map<pair<string, int>, double> baseline;
+  string name;
+  int length;
+  double ns_per_call;
+  while (f >> name >> length >> ns_per_call) {
+    baseline[make_pair(name, length)] = ns_per_call;
+  }
+  return baseline;
+}
+
+
+int main(int argc, char *argv[])
+{
+  BenchConfig config = ParseArgs(argc, argv);
+
+  // The search DSL as registered in RankedOpTable, plus the int->int ops of
+  // ops.h that the search currently leaves disabled.
+  RankedOpTable table;
+  vector<Successor> ops(table.Successors());
+  ops.push_back(Successor("increment", increment, Int, Int));
+  ops.push_back(Successor("decrement", decrement, Int, Int));
+
+  map<pair<string, int>, double> baseline;
+  if (!config.baseline_filename.empty())  baseline = LoadBaseline(config.baseline_filename);
+
+  ofstream save;
+  if (!config.save_filename.empty()) {
+    save.open(config.save_filename);
+    CHECK(save.is_open(), "Failed to open file " + config.save_filename);
+  }
+
+  mt19937 rng(config.seed);
+  int num_regressions = 0;
+
+  cout << left << setw(18) << "op" << right << setw(8) << "length" << setw(12) << "ns/call"
+       << setw(12) << "ns/elem";
+  if (!baseline.empty())  cout << setw(12) << "baseline" << setw(10) << "change";
+  cout << endl;
+  cout << fixed << setprecision(2);
+
+  for (auto &op : ops) {
+    if (op.Name().find(config.filter) == string::npos)  continue;
+
+    for (int length : config.lengths) {
+      double ns_per_call = TimeOp(op, length, config, rng);
+
+      cout << left << setw(18) << op.Name() << right << setw(8) << length
+           << setw(12) << ns_per_call << setw(12) << ns_per_call / max(length, 1);
+      if (save.is_open()) {
+        save << op.Name() << " " << length << " " << ns_per_call << endl;
+      }
+
+      auto it = baseline.find(make_pair(op.Name(), length));
+      if (it != baseline.end()) {
+        double change = ns_per_call / it->second - 1;
+        cout << setw(12) << it->second << setw(9) << 100 * change << "%";
+        if (change > config.threshold) {
+          cout << "  REGRESSION";
+          num_regressions++;
+        }
+      }
+      cout << endl;
+    }
+  }
+
+  if (!baseline.empty()) {
+    cout << num_regressions << " regression(s) above " << 100 * config.threshold << "%" << endl;
+  }
+  return num_regressions > 0 ? 1 : 0;
+}
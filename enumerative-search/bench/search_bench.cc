@@ -0,0 +1,549 @@
+// End-to-end search benchmark.
+//
+//   search_bench generate NAME [OPTIONS]
+//     Writes a reproducible corpus of random problems to data/NAME/, in the
+//     layout the search reads, together with a prior, noisy per-problem
+//     predictions, a random ordering and the generating programs.
+//
+//   search_bench run NAME [OPTIONS]
+//     Runs ./search on every problem of data/NAME/ with each ordering type,
+//     and reports total time, nodes/sec, solved fraction and per-length
+//     percentiles, optionally compared against a saved baseline.
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <math.h>
+#include <random>
+#include <set>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "utils.h"
+#include "datum.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+
+
+using namespace std;
+
+
+struct BenchConfig {
+  BenchConfig() :
+    num_problems(100), num_examples(5), min_length(1), max_length(5), array_length(10),
+    value_range(64), seed(0), orderings({0, 1, -1}), timeout_secs(10), threshold(0.1),
+    search_binary("./search")
+  {}
+
+  // generate
+  int num_problems;
+  int num_examples;
+  int min_length;
+  int max_length;
+  int array_length;
+  int value_range;
+  int seed;
+
+  // run
+  vector<int> orderings;
+  double timeout_secs;
+  double threshold;
+  string search_binary;
+  string save_filename;
+  string baseline_filename;
+};
+
+
+struct Statement {
+  int op_id;
+  vector<int> args;
+};
+
+
+// Outputs beyond this magnitude are rejected, so that corpus problems don't
+// depend on integer overflow.
+static const int kMaxAbsOutput = 1 << 20;
+static const int kMaxAttemptsPerProblem = 10000;
+
+
+static void Usage() {
+  cout << "Usage:" << endl;
+  cout << "  search_bench generate NAME [OPTIONS]" << endl;
+  cout << "  search_bench run NAME [OPTIONS]" << endl;
+  cout << "Options for generate:" << endl;
+  cout << "  --problems=P          number of problems (default 100)" << endl;
+  cout << "  --examples=N          examples per problem (default 5)" << endl;
+  cout << "  --lengths=MIN-MAX     program lengths, spread evenly (default 1-5)" << endl;
+  cout << "  --array_length=L      length of input arrays (default 10)" << endl;
+  cout << "  --value_range=V       input values are drawn from [-V, V) (default 64)" << endl;
+  cout << "  --seed=S              random seed (default 0)" << endl;
+  cout << "Options for run:" << endl;
+  cout << "  --examples=N          examples per problem (default 5)" << endl;
+  cout << "  --orderings=O1,O2,... ORDER_TYPEs to run (default 0,1,-1)" << endl;
+  cout << "  --timeout=S           per-search time limit in seconds (default 10)" << endl;
+  cout << "  --search=PATH         search binary (default ./search)" << endl;
+  cout << "  --save=FILE           save the report as a baseline" << endl;
+  cout << "  --baseline=FILE       compare against a saved baseline" << endl;
+  cout << "  --threshold=T         relative change reported as regression (default 0.1)" << endl;
+  exit(1);
+}
+
+
+static BenchConfig ParseArgs(int argc, char *argv[]) {
+  BenchConfig config;
+  for (int i = 3; i < argc; i++) {
+    string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == string::npos)  Usage();
+    string name = arg.substr(2, eq - 2);
+    string value = arg.substr(eq + 1);
+
+    if (name == "problems") {
+      config.num_problems = atoi(value.c_str());
+    } else if (name == "examples") {
+      config.num_examples = atoi(value.c_str());
+    } else if (name == "lengths") {
+      size_t dash = value.find('-');
+      config.min_length = atoi(value.substr(0, dash).c_str());
+      config.max_length = dash == string::npos ? config.min_length :
+        atoi(value.substr(dash + 1).c_str());
+    } else if (name == "array_length") {
+      config.array_length = atoi(value.c_str());
+    } else if (name == "value_range") {
+      config.value_range = atoi(value.c_str());
+    } else if (name == "seed") {
+      config.seed = atoi(value.c_str());
+    } else if (name == "orderings") {
+      config.orderings.clear();
+      stringstream ss(value);
+      string ordering;
+      while (getline(ss, ordering, ','))  config.orderings.push_back(atoi(ordering.c_str()));
+    } else if (name == "timeout") {
+      config.timeout_secs = atof(value.c_str());
+    } else if (name == "search") {
+      config.search_binary = value;
+    } else if (name == "save") {
+      config.save_filename = value;
+    } else if (name == "baseline") {
+      config.baseline_filename = value;
+    } else if (name == "threshold") {
+      config.threshold = atof(value.c_str());
+    } else {
+      Usage();
+    }
+  }
+  return config;
+}
+
+
+/*
+ *
+ * generate
+ *
+ */
+
+static string TypeName(DatumType type) {
+  return type == Int ? "Int" : "Array";
+}
+
+
+static string FormatDatum(Datum *d) {
+  stringstream ss;
+  if (d->Type() == Int) {
+    ss << d->GetIntValue();
+  } else {
+    for (int i = 0; i < d->Size(); i++)  ss << (i > 0 ? " " : "") << d->GetArrayElementValue(i);
+  }
+  return ss.str();
+}
+
+
+static bool InRange(Datum *d) {
+  if (d->Type() == Int)  return abs(d->GetIntValue()) <= kMaxAbsOutput;
+  for (int i = 0; i < d->Size(); i++) {
+    if (abs(d->GetArrayElementValue(i)) > kMaxAbsOutput)  return false;
+  }
+  return true;
+}
+
+
+// Samples a program of the given length in which every intermediate result
+// is used by a later statement.
+static bool SampleProgram(const RankedOpTable &table, int length, mt19937 &rng,
+                          vector<DatumType> *input_types, vector<Statement> *statements) {
+  static const vector<vector<DatumType> > signatures = {{Array}, {Int, Array}, {Array, Array}};
+  *input_types = signatures[rng() % signatures.size()];
+
+  vector<DatumType> types(*input_types);
+  vector<int> num_reads(types.size(), 0);
+  statements->clear();
+  for (int step = 0; step < length; step++) {
+    vector<int> candidates;
+    for (int id = 0; id < table.NumOps(); id++) {
+      const Successor &op = table.Op(id);
+      if (op.IsOp1() && count(types.begin(), types.end(), op.GetOp1ArgType()) > 0)  {
+        candidates.push_back(id);
+      } else if (op.IsOp2() && count(types.begin(), types.end(), op.GetOp2Arg1Type()) > 0 &&
+                 count(types.begin(), types.end(), op.GetOp2Arg2Type()) > 0) {
+        candidates.push_back(id);
+      }
+    }
+
+    Statement statement;
+    statement.op_id = candidates[rng() % candidates.size()];
+    const Successor &op = table.Op(statement.op_id);
+    vector<DatumType> arg_types;
+    if (op.IsOp1()) {
+      arg_types.push_back(op.GetOp1ArgType());
+    } else {
+      arg_types.push_back(op.GetOp2Arg1Type());
+      arg_types.push_back(op.GetOp2Arg2Type());
+    }
+    for (auto type : arg_types) {
+      vector<int> registers;
+      for (int j = 0; j < types.size(); j++) {
+        if (types[j] == type)  registers.push_back(j);
+      }
+      int arg = registers[rng() % registers.size()];
+      statement.args.push_back(arg);
+      num_reads[arg]++;
+    }
+
+    types.push_back(op.ResultType());
+    num_reads.push_back(0);
+    statements->push_back(statement);
+  }
+
+  for (int j = input_types->size(); j + 1 < types.size(); j++) {
+    if (num_reads[j] == 0)  return false;
+  }
+  return true;
+}
+
+
+// mt19937 is specified exactly, unlike the standard distributions, so these
+// keep the corpus identical across standard library implementations.
+static int RandomInt(mt19937 &rng, int lo, int hi) {
+  return lo + rng() % (uint32_t) (hi - lo + 1);
+}
+
+
+static double RandomUniform(mt19937 &rng) {
+  return rng() / 4294967296.0;
+}
+
+
+static Datum *RandomInput(DatumType type, const BenchConfig &config, mt19937 &rng) {
+  if (type == Int)  return new Datum(RandomInt(rng, 0, config.array_length));
+
+  vector<int> values(config.array_length);
+  for (auto &v : values)  v = RandomInt(rng, -config.value_range, config.value_range - 1);
+  return new Datum(values);
+}
+
+
+static void ApplyStatement(const RankedOpTable &table, const Statement &statement,
+                           ProgramState *ps) {
+  const Successor &op = table.Op(statement.op_id);
+  if (op.IsOp1()) {
+    ps->ApplyOp1(op.GetOp1(), statement.args[0]);
+  } else {
+    ps->ApplyOp2(op.GetOp2(), statement.args[0], statement.args[1]);
+  }
+}
+
+
+static void Generate(string test_set, const BenchConfig &config) {
+  string dir = "data/" + test_set;
+  mkdir(dir.c_str(), 0755);
+  mkdir((dir + "/predictions").c_str(), 0755);
+
+  ofstream input_types(dir + "/input_types.txt");
+  ofstream input_values(dir + "/input_values.txt");
+  ofstream output_types(dir + "/output_types.txt");
+  ofstream output_values(dir + "/output_values.txt");
+  ofstream programs(dir + "/programs.txt");
+  CHECK(input_types.is_open() && input_values.is_open() && output_types.is_open() &&
+        output_values.is_open() && programs.is_open(), "Failed to create files in " + dir);
+
+  RankedOpTable table;
+  vector<string> component_names = RankedOpTable::ComponentNames();
+  map<string, int> component_counts;
+  mt19937 rng(config.seed);
+
+  int num_lengths = config.max_length - config.min_length + 1;
+  for (int problem_idx = 0; problem_idx < config.num_problems; problem_idx++) {
+    int length = config.min_length + problem_idx % num_lengths;
+
+    vector<DatumType> types;
+    vector<Statement> statements;
+    vector<ProgramState *> examples;
+    bool accepted = false;
+    for (int attempt = 0; attempt < kMaxAttemptsPerProblem && !accepted; attempt++) {
+      for (auto &ps : examples)  delete ps;
+      examples.clear();
+      if (!SampleProgram(table, length, rng, &types, &statements))  continue;
+
+      accepted = true;
+      for (int e = 0; e < config.num_examples; e++) {
+        vector<Datum *> inputs;
+        for (auto type : types)  inputs.push_back(RandomInput(type, config, rng));
+        ProgramState *ps = new ProgramState(inputs);
+        for (auto &statement : statements)  ApplyStatement(table, statement, ps);
+        examples.push_back(ps);
+        // Undefined results (see Datum) carry through to the output.
+        accepted = accepted && ps->GetLastDatum()->Defined() && InRange(ps->GetLastDatum());
+      }
+      if (!accepted)  continue;
+
+      // Reject programs whose output is the same on every example, or
+      // equal to one of the inputs.
+      bool constant = true;
+      for (int e = 1; e < examples.size(); e++) {
+        constant = constant && *examples[e]->GetLastDatum() == *examples[0]->GetLastDatum();
+      }
+      bool copies_input = false;
+      for (int j = 0; j < types.size(); j++) {
+        bool same = true;
+        for (auto &ps : examples)  same = same && *ps->GetLastDatum() == *ps->GetDatum(j);
+        copies_input = copies_input || same;
+      }
+      accepted = !constant && !copies_input;
+    }
+    CHECK(accepted, "Failed to generate a problem of length " + to_string(length));
+
+    for (int j = 0; j < types.size(); j++)  input_types << (j > 0 ? " " : "") << TypeName(types[j]);
+    input_types << endl;
+    output_types << TypeName(examples[0]->GetLastDatum()->Type()) << endl;
+    for (auto &ps : examples) {
+      for (int j = 0; j < types.size(); j++) {
+        input_values << (j > 0 ? " | " : "") << FormatDatum(ps->GetDatum(j));
+      }
+      input_values << endl;
+      output_values << FormatDatum(ps->GetLastDatum()) << endl;
+      delete ps;
+    }
+
+    // Ground truth in the search's output syntax, statements separated by " | ".
+    set<string> used_components;
+    for (int s = 0; s < statements.size(); s++) {
+      const Successor &op = table.Op(statements[s].op_id);
+      programs << (s > 0 ? " | " : "") << "%" << types.size() + s << " <- " << op.Name();
+      for (int arg : statements[s].args)  programs << " %" << arg;
+      for (auto &component : RankedOpTable::Components(op.Name())) {
+        used_components.insert(component);
+      }
+    }
+    programs << endl;
+
+    // Noisy predictions: components of the program score higher on average.
+    ofstream predictions(dir + "/predictions/" + to_string(problem_idx) + ".txt");
+    for (auto &name : component_names) {
+      bool used = used_components.count(name) > 0;
+      predictions << (used ? 0.4 + 0.6 * RandomUniform(rng) : 0.6 * RandomUniform(rng)) << " " << name << endl;
+      if (used)  component_counts[name]++;
+    }
+  }
+
+  // The prior reflects how often each component occurs in the corpus.
+  ofstream prior(dir + "/prior.txt");
+  ofstream random_ordering(dir + "/random_ordering_1.txt");
+  for (auto &name : component_names) {
+    prior << (double) component_counts[name] / config.num_problems << " " << name << endl;
+    random_ordering << RandomUniform(rng) << " " << name << endl;
+  }
+
+  cout << "Wrote " << config.num_problems << " problems with " << config.num_examples
+       << " examples each to " << dir << endl;
+}
+
+
+/*
+ *
+ * run
+ *
+ */
+
+struct SearchRun {
+  int length;
+  bool solved;
+  bool timed_out;
+  long nodes;
+  double secs;
+};
+
+
+static SearchRun RunSearch(string test_set, int problem_idx, int length, int ordering,
+                           const BenchConfig &config) {
+  stringstream command;
+  command << "timeout " << config.timeout_secs << " " << config.search_binary << " "
+          << test_set << " " << config.num_examples << " " << length << " " << problem_idx
+          << " " << ordering << " -1 2>&1";
+
+  FILE *pipe = popen(command.str().c_str(), "r");
+  CHECK_NOT_NULL(pipe, "Failed to run " + command.str());
+
+  SearchRun run;
+  run.length = length;
+  run.solved = false;
+  run.timed_out = true;
+  run.nodes = 0;
+  run.secs = config.timeout_secs;
+
+  char buffer[4096];
+  while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
+    string line = buffer;
+    double cpu_secs, real_secs;
+    if (sscanf(buffer, "Time Elapsed: %lf (CPU), %lf (Real) secs", &cpu_secs, &real_secs) == 2) {
+      run.secs = real_secs;
+      run.timed_out = false;
+    } else if (line.compare(0, 7, "Solved!") == 0) {
+      run.solved = true;
+    } else if (line.compare(0, 15, "Nodes explored:") == 0) {
+      run.nodes = atol(line.substr(15).c_str());
+    }
+  }
+  pclose(pipe);
+  return run;
+}
+
+
+static double Percentile(vector<double> values, double q) {
+  if (values.empty())  return 0;
+  sort(values.begin(), values.end());
+  int idx = min((int) values.size() - 1, (int) ceil(q * values.size()) - 1);
+  return values[max(idx, 0)];
+}
+
+
+static vector<int> LoadProgramLengths(string test_set) {
+  string filename = "data/" + test_set + "/programs.txt";
+  ifstream f;
+  f.open(filename);
+  CHECK(f.is_open(), "Failed to open file " + filename);
+
+  vector<int> lengths;
+  string line;
+  while (getline(f, line))  lengths.push_back(count(line.begin(), line.end(), '|') + 1);
+  return lengths;
+}
+
+
+// Metrics where larger values are better; everything else regresses upwards.
+static bool HigherIsBetter(string metric) {
+  return metric.find("solved_frac") != string::npos || metric.find("nodes_per_sec") != string::npos;
+}
+
+
+static void Run(string test_set, const BenchConfig &config) {
+  vector<int> lengths = LoadProgramLengths(test_set);
+
+  map<string, double> baseline;
+  if (!config.baseline_filename.empty()) {
+    ifstream f;
+    f.open(config.baseline_filename);
+    CHECK(f.is_open(), "Failed to open file " + config.baseline_filename);
+    string metric;
+    double value;
+    while (f >> metric >> value)  baseline[metric] = value;
+  }
+
+  vector<pair<string, double> > report;
+  for (int ordering : config.orderings) {
+    vector<SearchRun> runs;
+    for (int problem_idx = 0; problem_idx < lengths.size(); problem_idx++) {
+      runs.push_back(RunSearch(test_set, problem_idx, lengths[problem_idx], ordering, config));
+    }
+
+    int num_solved = 0, num_timed_out = 0;
+    long total_nodes = 0;
+    double total_secs = 0, completed_secs = 0;
+    for (auto &run : runs) {
+      num_solved += run.solved;
+      num_timed_out += run.timed_out;
+      total_secs += run.secs;
+      if (!run.timed_out) {
+        total_nodes += run.nodes;
+        completed_secs += run.secs;
+      }
+    }
+
+    string prefix = "order" + to_string(ordering) + ".";
+    cout << "ORDER_TYPE " << ordering << ": solved " << num_solved << "/" << runs.size()
+         << ", timed out " << num_timed_out << ", total " << fixed << setprecision(3)
+         << total_secs << " s, " << setprecision(0)
+         << (completed_secs > 0 ? total_nodes / completed_secs : 0) << " nodes/sec" << endl;
+    report.push_back(make_pair(prefix + "solved_frac", (double) num_solved / runs.size()));
+    report.push_back(make_pair(prefix + "total_secs", total_secs));
+    report.push_back(make_pair(prefix + "nodes_per_sec",
+                               completed_secs > 0 ? total_nodes / completed_secs : 0));
+
+    cout << "  length  problems  solved    p50_secs    p90_secs    max_secs   p50_nodes   p90_nodes"
+         << endl;
+    for (int length = 1; length <= *max_element(lengths.begin(), lengths.end()); length++) {
+      vector<double> secs, nodes;
+      int solved = 0;
+      for (auto &run : runs) {
+        if (run.length != length)  continue;
+        secs.push_back(run.secs);
+        nodes.push_back(run.nodes);
+        solved += run.solved;
+      }
+      if (secs.empty())  continue;
+
+      cout << setw(8) << length << setw(10) << secs.size() << setw(8) << solved
+           << setprecision(4) << setw(12) << Percentile(secs, 0.5) << setw(12)
+           << Percentile(secs, 0.9) << setw(12) << Percentile(secs, 1.0) << setprecision(0)
+           << setw(12) << Percentile(nodes, 0.5) << setw(12) << Percentile(nodes, 0.9) << endl;
+      string length_prefix = prefix + "len" + to_string(length) + ".";
+      report.push_back(make_pair(length_prefix + "p50_secs", Percentile(secs, 0.5)));
+      report.push_back(make_pair(length_prefix + "p90_secs", Percentile(secs, 0.9)));
+      report.push_back(make_pair(length_prefix + "solved_frac", (double) solved / secs.size()));
+    }
+  }
+
+  if (!config.save_filename.empty()) {
+    ofstream save(config.save_filename);
+    CHECK(save.is_open(), "Failed to open file " + config.save_filename);
+    save << setprecision(9);
+    for (auto &metric : report)  save << metric.first << " " << metric.second << endl;
+  }
+
+  if (!baseline.empty()) {
+    int num_regressions = 0;
+    cout << endl << "Compared to " << config.baseline_filename << ":" << endl;
+    for (auto &metric : report) {
+      auto it = baseline.find(metric.first);
+      if (it == baseline.end())  continue;
+      double change = it->second != 0 ? metric.second / it->second - 1 : 0;
+      bool regression = HigherIsBetter(metric.first) ? change < -config.threshold :
+        change > config.threshold;
+      cout << "  " << left << setw(28) << metric.first << right << setprecision(4)
+           << setw(14) << it->second << " -> " << setw(14) << metric.second
+           << setprecision(1) << setw(9) << 100 * change << "%"
+           << (regression ? "  REGRESSION" : "") << endl;
+      num_regressions += regression;
+    }
+    cout << num_regressions << " regression(s) above " << 100 * config.threshold << "%" << endl;
+    if (num_regressions > 0)  exit(1);
+  }
+}
+
+
+int main(int argc, char *argv[])
+{
+  if (argc < 3)  Usage();
+  string mode = argv[1];
+  string test_set = argv[2];
+  BenchConfig config = ParseArgs(argc, argv);
+
+  if (mode == "generate") {
+    Generate(test_set, config);
+  } else if (mode == "run") {
+    Run(test_set, config);
+  } else {
+    Usage();
+  }
+}
@@ -46,22 +46,26 @@ bool operator!=(const Datum &lhs, const Datum &rhs) {
 }
 
 
-Datum::Datum()
+Datum::Datum() :
+  defined_(true)
 {}
 
 
 Datum::Datum(DatumType type) :
-  type_(type)
+  type_(type),
+  defined_(true)
 {}
 
 
-Datum::Datum(int value)
+Datum::Datum(int value) :
+  defined_(true)
 {
   SetIntValue(value);
 }
 
 
-Datum::Datum(const vector<int> &values)
+Datum::Datum(const vector<int> &values) :
+  defined_(true)
 {
   SetArrayValue(values);
 }
@@ -125,3 +129,13 @@ int Datum::Size() const {
 vector<int> *Datum::GetValues() {
   return &values_;
 }
+
+
+bool Datum::Defined() const {
+  return defined_;
+}
+
+
+void Datum::SetDefined(bool defined) {
+  defined_ = defined;
+}
@@ -33,9 +33,16 @@ class Datum {
   vector<int> *GetValues();
   void SetValues(vector<int> &values);
 
+  // Ops clear this when their preconditions fail, e.g. access out of range,
+  // whose value is then a placeholder that generate_io_samples.py never
+  // produces. ProgramState sets it from the arguments before each op.
+  bool Defined() const;
+  void SetDefined(bool defined);
+
  protected:
   vector<int> values_;
   DatumType type_;
+  bool defined_;
 
   friend ostream &operator<<(ostream &os, const Datum &d);
 };
@@ -0,0 +1,237 @@
+#include "deepcoder_search.h"
+#include "datum.h"
+#include "depth_first_search.h"
+#include "io_set.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include "search_budget.h"
+#include "search_options.h"
+#include "solution_set.h"
+#include "utils.h"
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+struct dc_io_set {
+  vector<DatumType> input_types;
+  DatumType output_type;
+  // Per example, the values of the inputs followed by those of the output.
+  vector<vector<vector<int> > > examples;
+};
+
+
+struct dc_search_result {
+  int status;
+  string stop_reason;
+  long nodes_explored;
+  long nodes_pruned;
+  double secs;
+  vector<string> programs;
+  vector<vector<Successor> > statements;
+  vector<vector<string> > op_names;
+};
+
+
+static const vector<string> &ComponentNames() {
+  static const vector<string> names = RankedOpTable::ComponentNames();
+  return names;
+}
+
+
+static Datum *NewDatum(DatumType type, const vector<int> &values) {
+  return type == Int ? new Datum(values[0]) : new Datum(values);
+}
+
+
+void dc_search_options_init(dc_search_options *options) {
+  options->max_program_length = 5;
+  options->sort_and_add_cutoff = -1;
+  options->top_k = 1;
+  options->max_secs = 0;
+  options->max_nodes = 0;
+  options->max_mem_mb = 0;
+  options->prune_ranges = 0;
+  options->prune_feasibility = 0;
+}
+
+
+int dc_num_components(void) {
+  return ComponentNames().size();
+}
+
+
+const char *dc_component_name(int idx) {
+  if (idx < 0 || idx >= ComponentNames().size())  return NULL;
+  return ComponentNames()[idx].c_str();
+}
+
+
+dc_io_set *dc_io_set_create(int num_inputs, const int *input_types, int output_type) {
+  if (num_inputs < 1 || (output_type != DC_INT && output_type != DC_ARRAY))  return NULL;
+  dc_io_set *io = new dc_io_set();
+  for (int i = 0; i < num_inputs; i++) {
+    if (input_types[i] != DC_INT && input_types[i] != DC_ARRAY) {
+      delete io;
+      return NULL;
+    }
+    io->input_types.push_back(input_types[i] == DC_INT ? Int : Array);
+  }
+  io->output_type = output_type == DC_INT ? Int : Array;
+  return io;
+}
+
+
+int dc_io_set_add_example(dc_io_set *io, const int *values, const int *lengths) {
+  vector<DatumType> types = io->input_types;
+  types.push_back(io->output_type);
+
+  vector<vector<int> > example;
+  for (int i = 0; i < types.size(); i++) {
+    if (lengths[i] < 0 || (types[i] == Int && lengths[i] != 1))  return -1;
+    example.push_back(vector<int>(values, values + lengths[i]));
+    values += lengths[i];
+  }
+  io->examples.push_back(example);
+  return 0;
+}
+
+
+int dc_io_set_num_examples(const dc_io_set *io) {
+  return io->examples.size();
+}
+
+
+void dc_io_set_free(dc_io_set *io) {
+  delete io;
+}
+
+
+dc_search_result *dc_search(const dc_io_set *io, const double *component_scores,
+                            const dc_search_options *options) {
+  if (io->examples.empty() || options->max_program_length < 1 || options->top_k < 1 ||
+      options->max_mem_mb != 0) {
+    return NULL;
+  }
+
+  MyTimer timer;
+  timer.tic();
+
+  SearchOptions search_options;
+  search_options.max_secs = options->max_secs;
+  search_options.max_nodes = options->max_nodes;
+  search_options.top_k = options->top_k;
+  search_options.prune_ranges = options->prune_ranges != 0;
+  search_options.prune_feasibility = options->prune_feasibility != 0;
+
+  // Every search gets its own registers, so that searches on the same
+  // examples can run at the same time.
+  int num_inputs = io->input_types.size();
+  vector<ProgramState *> inputs;
+  vector<Datum *> outputs;
+  for (auto &example : io->examples) {
+    vector<Datum *> data;
+    for (int i = 0; i < num_inputs; i++)  data.push_back(NewDatum(io->input_types[i], example[i]));
+    inputs.push_back(new ProgramState(data));
+    outputs.push_back(NewDatum(io->output_type, example[num_inputs]));
+  }
+  IOSet search_io(inputs, outputs);
+
+  RankedOpTable *table;
+  if (component_scores == NULL) {
+    table = new RankedOpTable();
+  } else {
+    vector<double> scores(component_scores, component_scores + ComponentNames().size());
+    table = new RankedOpTable(scores, options->sort_and_add_cutoff);
+  }
+
+  SearchBudget budget(search_options);
+  budget.Start();
+  SolutionSet solutions(search_options.top_k, NULL);
+  // Without a SearchStats, INSTRUMENT_MODE builds count nothing here;
+  // callers on several threads would need one each.
+  DepthFirstSearch dfs(table, &search_io, options->max_program_length, search_options, &budget,
+                       &solutions, NULL);
+  dfs.Search(options->max_program_length, vector<int>(), false);
+
+  dc_search_result *result = new dc_search_result();
+  result->stop_reason = budget.Reason();
+  result->status = !result->stop_reason.empty() ? DC_STOPPED : dfs.Solved() ? DC_SOLVED : DC_FAILED;
+  result->nodes_explored = dfs.NumNodesExplored();
+  result->nodes_pruned = dfs.NumNodesPruned();
+  result->programs = dfs.SolutionPrograms();
+  result->statements = dfs.SolutionStatements();
+  for (auto &statements : result->statements) {
+    result->op_names.push_back(vector<string>());
+    for (auto &statement : statements)  result->op_names.back().push_back(statement.Name());
+  }
+  timer.toc(false, NULL, &result->secs);
+
+  delete table;
+  return result;
+}
+
+
+int dc_result_status(const dc_search_result *result) {
+  return result->status;
+}
+
+
+const char *dc_result_stop_reason(const dc_search_result *result) {
+  return result->stop_reason.c_str();
+}
+
+
+long dc_result_nodes_explored(const dc_search_result *result) {
+  return result->nodes_explored;
+}
+
+
+long dc_result_nodes_pruned(const dc_search_result *result) {
+  return result->nodes_pruned;
+}
+
+
+double dc_result_secs(const dc_search_result *result) {
+  return result->secs;
+}
+
+
+int dc_result_num_solutions(const dc_search_result *result) {
+  return result->programs.size();
+}
+
+
+const char *dc_result_program(const dc_search_result *result, int solution) {
+  if (solution < 0 || solution >= result->programs.size())  return NULL;
+  return result->programs[solution].c_str();
+}
+
+
+int dc_result_num_statements(const dc_search_result *result, int solution) {
+  if (solution < 0 || solution >= result->statements.size())  return 0;
+  return result->statements[solution].size();
+}
+
+
+int dc_result_statement(const dc_search_result *result, int solution, int statement,
+                        const char **op_name, int *arg1, int *arg2) {
+  if (statement < 0 || statement >= dc_result_num_statements(result, solution))  return 0;
+  const Successor &successor = result->statements[solution][statement];
+  *op_name = result->op_names[solution][statement].c_str();
+  if (successor.IsOp1()) {
+    *arg1 = successor.GetOp1Arg();
+    *arg2 = -1;
+    return 1;
+  }
+  *arg1 = successor.GetOp2Arg1();
+  *arg2 = successor.GetOp2Arg2();
+  return 2;
+}
+
+
+void dc_result_free(dc_search_result *result) {
+  delete result;
+}
@@ -0,0 +1,114 @@
+/*
+ * C interface to the enumerative search, for use from other languages
+ * (e.g. Python via ctypes) without writing data files or starting `search`.
+ * Build it with `make lib`, which produces libdeepcoder_search.so.
+ *
+ * Typical use:
+ *
+ *   int input_types[] = {DC_INT, DC_ARRAY};
+ *   dc_io_set *io = dc_io_set_create(2, input_types, DC_INT);
+ *   int values[] = {8,  7, 9, 3, 1,  7};   // inputs, then the output
+ *   int lengths[] = {1, 4, 1};
+ *   dc_io_set_add_example(io, values, lengths);
+ *   ...
+ *   dc_search_options options;
+ *   dc_search_options_init(&options);
+ *   options.max_program_length = 3;
+ *   dc_search_result *result = dc_search(io, scores, &options);
+ *   if (dc_result_status(result) == DC_SOLVED)  puts(dc_result_program(result, 0));
+ *   dc_result_free(result);
+ *   dc_io_set_free(io);
+ *
+ * Functions taking const objects may be called from several threads at
+ * once; searches are independent of each other. Builds with
+ * INSTRUMENT_MODE do not collect statistics for these searches.
+ */
+
+#ifndef _DEEPCODER_SEARCH__
+#define _DEEPCODER_SEARCH__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Types of inputs and outputs. */
+#define DC_INT 0
+#define DC_ARRAY 1
+
+/* Status of a search. */
+#define DC_FAILED 0
+#define DC_SOLVED 1
+#define DC_STOPPED 2
+
+typedef struct dc_io_set dc_io_set;
+typedef struct dc_search_result dc_search_result;
+
+typedef struct {
+  int max_program_length;
+  /* Only the sort_and_add_cutoff most likely ops are used; -1 for all. */
+  int sort_and_add_cutoff;
+  /* Number of distinct solutions to find before stopping. */
+  int top_k;
+  /* Limits; 0 means unlimited. */
+  double max_secs;
+  long max_nodes;
+  /* Must be 0. The search can only read the peak memory of the whole
+   * process, which never goes down, so after one spike in the caller every
+   * later search would stop at once. */
+  long max_mem_mb;
+  /* Nonzero to enable --prune_ranges and --prune_feasibility. */
+  int prune_ranges;
+  int prune_feasibility;
+} dc_search_options;
+
+/* Sets the defaults: programs of up to 5 statements, all ops, no limits. */
+void dc_search_options_init(dc_search_options *options);
+
+/* Components of the DSL, whose scores rank the ops (see dc_search). */
+int dc_num_components(void);
+const char *dc_component_name(int idx);
+
+/* Creates a set without examples, for inputs and output of the given types
+ * (DC_INT or DC_ARRAY). Returns NULL if a type is invalid. */
+dc_io_set *dc_io_set_create(int num_inputs, const int *input_types, int output_type);
+
+/* Adds an example. values holds the values of the inputs followed by those
+ * of the output, and lengths the number of values of each of them, which
+ * must be 1 for DC_INT. Returns 0, or -1 if the lengths do not fit the
+ * types. */
+int dc_io_set_add_example(dc_io_set *io, const int *values, const int *lengths);
+int dc_io_set_num_examples(const dc_io_set *io);
+void dc_io_set_free(dc_io_set *io);
+
+/* Searches for programs consistent with all examples of io. Ops are tried
+ * in the order of the scores of their components, which hold one score per
+ * component in dc_component_name order; NULL tries all ops in a fixed
+ * order. Returns NULL if io has no examples or the options are invalid,
+ * which includes a nonzero max_mem_mb. */
+dc_search_result *dc_search(const dc_io_set *io, const double *component_scores,
+                            const dc_search_options *options);
+
+int dc_result_status(const dc_search_result *result);
+/* Which limit stopped the search (e.g. "max_secs"), or "". */
+const char *dc_result_stop_reason(const dc_search_result *result);
+long dc_result_nodes_explored(const dc_search_result *result);
+long dc_result_nodes_pruned(const dc_search_result *result);
+double dc_result_secs(const dc_search_result *result);
+
+/* Solutions, each as text with one statement per line (registers are
+ * numbered from the inputs on) and as a list of statements. */
+int dc_result_num_solutions(const dc_search_result *result);
+const char *dc_result_program(const dc_search_result *result, int solution);
+int dc_result_num_statements(const dc_search_result *result, int solution);
+/* Returns the number of arguments (1 or 2) of a statement, and sets its op
+ * name and argument registers. arg2 is -1 for ops of one argument. */
+int dc_result_statement(const dc_search_result *result, int solution, int statement,
+                        const char **op_name, int *arg1, int *arg2);
+
+void dc_result_free(dc_search_result *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,10 +1,359 @@
 #include "depth_first_search.h"
+#include "backward_subgoals.h"
+#include "feasibility.h"
 #include "io_set.h"
+#include "leaf_evaluator.h"
+#include "node_scorer.h"
+#include "program_state.h"
+#include "range_analysis.h"
+#include "ranked_op_table.h"
+#include "search_budget.h"
+#include "search_checkpoint.h"
+#include "search_options.h"
+#include "search_stats.h"
+#include "solution_set.h"
+#include "successor.h"
+#include "utils.h"
 
 
-DepthFirstSearch::DepthFirstSearch(IOSet *io) {
+DepthFirstSearch::DepthFirstSearch(const RankedOpTable *table, IOSet *io, int max_program_length,
+                                   const SearchOptions &options, SearchBudget *budget,
+                                   SolutionSet *solutions, BackwardSubgoals *subgoals) :
+  table_(table),
+  io_(io),
+  max_program_length_(max_program_length),
+  num_inputs_(io->GetInputs(0)->NumUsed()),
+  budget_(budget),
+  solutions_(solutions),
+  subgoals_(subgoals),
+  stats_(NULL),
+  solution_log_(NULL),
+  checkpoint_(NULL),
+  scorer_(NULL),
+  prune_unused_(options.prune_unused),
+  prune_rewrites_(options.prune_rewrites),
+  prune_undefined_(options.prune_undefined),
+  unread_(max_program_length, 0),
+  solved_(false),
+  num_nodes_explored_(0),
+  num_nodes_pruned_(0),
+  nodes_per_depth_(max_program_length, 0),
+  prefix_(max_program_length, NULL),
+  deepest_depth_(-1)
+{
+  if (!options.scorer_filename.empty())  scorer_ = new LinearScorer(options.scorer_filename, table);
+  ranges_ = options.prune_ranges ? new RangeAnalysis(table, io) : NULL;
+  feasibility_ = options.prune_feasibility ? new FeasibilityCheck(table, io) : NULL;
+  leaf_evaluator_ = new LeafEvaluator(table, io, options.prune_undefined);
+  CHECK(prune_unused_ == 0 || num_inputs_ + max_program_length <= 64,
+        "--prune_unused supports programs of up to 64 registers");
 
+  for (int i = 0; i < max_program_length; i++) {
+    iterators_.push_back(new SuccessorIterator(table, io));
+    iterators_.back()->SetScorer(scorer_);
+  }
 }
 
 
-DepthFirstSearch::~DepthFirstSearch() {}
+DepthFirstSearch::~DepthFirstSearch() {
+  for (auto iterator : iterators_)  delete iterator;
+  delete scorer_;
+  delete ranges_;
+  delete feasibility_;
+  delete leaf_evaluator_;
+}
+
+
+void DepthFirstSearch::SetStats(SearchStats *stats) {
+  stats_ = stats;
+}
+
+
+void DepthFirstSearch::SetSolutionLog(ostream *log) {
+  solution_log_ = log;
+}
+
+
+void DepthFirstSearch::SetCheckpoint(SearchCheckpoint *checkpoint) {
+  checkpoint_ = checkpoint;
+}
+
+
+void DepthFirstSearch::Search(int search_length, const vector<int> &start, bool use_subgoals) {
+  Run(search_length, start, vector<int>(), use_subgoals, 0, NULL);
+}
+
+
+void DepthFirstSearch::Resume(int search_length, const SearchCheckpoint &checkpoint,
+                              bool use_subgoals) {
+  num_nodes_explored_ = checkpoint.num_nodes_explored;
+  num_nodes_pruned_ = checkpoint.num_nodes_pruned;
+  for (int i = 0; i < checkpoint.nodes_per_depth.size() && i < max_program_length_; i++) {
+    nodes_per_depth_[i] = checkpoint.nodes_per_depth[i];
+  }
+
+  for (auto &solution : checkpoint.solutions) {
+    vector<const Successor *> program;
+    for (auto &statement : solution)  program.push_back(&statement);
+    solutions_->Add(program, program.size());
+    solved_ = true;
+    solution_programs_.push_back(FormatProgram(program, program.size(), num_inputs_));
+    solution_statements_.push_back(solution);
+    if (solution_log_ != NULL) {
+      *solution_log_ << "Solution " << solutions_->Size() << " (from checkpoint):" << endl
+                     << solution_programs_.back() << flush;
+    }
+  }
+
+  Run(search_length, vector<int>(), checkpoint.positions, use_subgoals, 0, NULL);
+}
+
+
+void DepthFirstSearch::Partition(int search_length, int partition_length, bool use_subgoals,
+                                 vector<vector<int> > &tasks) {
+  Run(search_length, vector<int>(), vector<int>(), use_subgoals,
+      min(partition_length, search_length), &tasks);
+}
+
+
+void DepthFirstSearch::Run(int search_length, const vector<int> &start, const vector<int> &resume,
+                           bool use_subgoals, int partition_length, vector<vector<int> > *tasks) {
+  int pinned = start.size();
+  int depth = 0;
+  stop_prefix_ = "";
+  if (prune_rewrites_) {
+    // Subgoal programs continue after the last depth.
+    for (int i = 0; i < search_length; i++) {
+      iterators_[i]->SetPrefix(&prefix_, i == search_length - 1 && !use_subgoals);
+    }
+  }
+  iterators_[0]->Init(io_);
+  if (pinned > 0)  iterators_[0]->Seek(start[0]);
+
+  // A resumed search replays the path of its checkpoint, whose nodes were
+  // counted before, and goes on after the last position.
+  for (; depth + 1 < resume.size(); depth++) {
+    iterators_[depth]->Seek(resume[depth] - 1);
+    prefix_[depth] = iterators_[depth]->Next();
+    LeavesUnused(depth, prefix_[depth]);
+    ApplySuccessor(io_, prefix_[depth]);
+    iterators_[depth + 1]->Init(io_);
+  }
+  if (!resume.empty())  iterators_[depth]->Seek(resume[depth]);
+
+  while (depth >= 0) {
+    // Iterators of the prefix only return its statement.
+    const Successor *successor = NULL;
+    if (depth >= pinned || iterators_[depth]->Position() == start[depth]) {
+      successor = iterators_[depth]->Next();
+    }
+
+    if (successor == NULL) {
+      // The inputs stay when the first iterator runs out.
+      depth -= 1;
+      if (depth >= 0)  io_->Pop();
+      continue;
+    }
+
+    if (prune_unused_ != 0 && LeavesUnused(depth, successor)) {
+      num_nodes_pruned_++;
+      INSTRUMENT(if (stats_ != NULL)  stats_->RecordPruned(depth, successor->Id()));
+      continue;
+    }
+
+    // Nodes at the last depth are only compared with the targets, unless
+    // their registers are needed to match subgoals.
+    bool leaf = depth == search_length - 1 && !use_subgoals && depth != partition_length - 1;
+    if (!leaf) {
+      INSTRUMENT(uint64_t apply_start =
+                 stats_ != NULL ? stats_->BeginApply(depth, successor->Id()) : 0);
+      ApplySuccessor(io_, successor);
+      INSTRUMENT(if (stats_ != NULL)  stats_->EndApply(depth, successor->Id(), apply_start));
+      if (prune_undefined_ && !io_->LastDefined()) {
+        io_->Pop();
+        num_nodes_pruned_++;
+        INSTRUMENT(if (stats_ != NULL)  stats_->RecordPruned(depth, successor->Id()));
+        continue;
+      }
+    }
+    prefix_[depth] = successor;
+
+    if (depth < pinned - 1) {
+      depth += 1;
+      iterators_[depth]->Init(io_);
+      iterators_[depth]->Seek(start[depth]);
+      continue;
+    }
+
+    if (depth == partition_length - 1) {
+      vector<int> task;
+      for (int i = 0; i <= depth; i++)  task.push_back(iterators_[i]->Position() - 1);
+      tasks->push_back(task);
+      io_->Pop();
+      continue;
+    }
+
+    num_nodes_explored_++;
+    nodes_per_depth_[depth]++;
+    if (depth > deepest_depth_) {
+      deepest_depth_ = depth;
+      deepest_prefix_ = FormatProgram(prefix_, depth + 1, num_inputs_);
+    }
+
+    bool solved;
+    if (leaf) {
+      INSTRUMENT(uint64_t apply_start =
+                 stats_ != NULL ? stats_->BeginApply(depth, successor->Id()) : 0);
+      solved = leaf_evaluator_->Solves(io_, successor);
+      INSTRUMENT(if (stats_ != NULL)  stats_->EndApply(depth, successor->Id(), apply_start));
+    } else if (prune_unused_ == SearchOptions::kPruneNonMinimal &&
+               __builtin_popcountll(unread_[depth]) > 1) {
+      // A program with dead statements is no solution, but later statements
+      // may still read its registers.
+      solved = false;
+    } else {
+      solved = io_->IsSolved();
+    }
+    if (solved) {
+      INSTRUMENT(if (stats_ != NULL)  stats_->RecordGoalHit(depth, successor->Id()));
+      solved_ = true;
+      if (solutions_->Add(prefix_, depth + 1)) {
+        solution_programs_.push_back(FormatProgram(prefix_, depth + 1, num_inputs_));
+        solution_statements_.push_back(vector<Successor>());
+        for (int i = 0; i <= depth; i++)  solution_statements_.back().push_back(*prefix_[i]);
+        if (solution_log_ != NULL) {
+          *solution_log_ << "Solution " << solutions_->Size() << " (nodes explored: "
+                         << num_nodes_explored_ << "):" << endl << solution_programs_.back()
+                         << flush;
+        }
+      }
+      if (solutions_->Full())  break;
+    }
+
+    if (!solved && use_subgoals) {
+      int reg = num_inputs_ + depth;
+      int match = subgoals_->Match(io_, reg, max_program_length_ - depth - 1);
+      if (match >= 0) {
+        vector<Successor> completion = subgoals_->Completion(match, reg, reg + 1);
+        CHECK(Solves(io_, completion), "Backward subgoal completion does not solve the problem");
+        vector<const Successor *> program(prefix_.begin(), prefix_.begin() + depth + 1);
+        for (auto &statement : completion)  program.push_back(&statement);
+        solution_programs_.push_back(FormatProgram(program, program.size(), num_inputs_));
+        solution_statements_.push_back(vector<Successor>());
+        for (auto statement : program)  solution_statements_.back().push_back(*statement);
+        solved_ = true;
+        break;
+      }
+    }
+
+    if (budget_->Exhausted(num_nodes_explored_)) {
+      stop_prefix_ = FormatProgram(prefix_, depth + 1, num_inputs_);
+      // The subtree of the current node is not searched yet.
+      if (checkpoint_ != NULL)  SaveCheckpoint(depth, !solved);
+      break;
+    }
+
+    // Programs extending a solution are not searched.
+    bool descend = !solved && depth < search_length - 1;
+    int remaining_steps = max_program_length_ - 1 - depth;
+    if (descend &&
+        ((feasibility_ != NULL && !feasibility_->Feasible(io_, remaining_steps)) ||
+         (ranges_ != NULL && !ranges_->CanReach(io_, remaining_steps)))) {
+      descend = false;
+      num_nodes_pruned_++;
+      INSTRUMENT(if (stats_ != NULL)  stats_->RecordPruned(depth, successor->Id()));
+    }
+
+    if (descend) {
+      depth += 1;
+      iterators_[depth]->Init(io_);
+    } else if (!leaf) {
+      io_->Pop();
+    }
+
+    if (checkpoint_ != NULL && (num_nodes_explored_ & (SearchBudget::kCheckInterval - 1)) == 0 &&
+        checkpoint_->Due()) {
+      SaveCheckpoint(depth, false);
+    }
+  }
+
+  // A search stopped early leaves the registers of its current program.
+  while (io_->GetInputs(0)->NumUsed() > num_inputs_)  io_->Pop();
+}
+
+
+void DepthFirstSearch::SaveCheckpoint(int depth, bool redo_current) {
+  checkpoint_->positions.clear();
+  for (int i = 0; i <= depth; i++)  checkpoint_->positions.push_back(iterators_[i]->Position());
+  checkpoint_->num_nodes_explored = num_nodes_explored_;
+  checkpoint_->num_nodes_pruned = num_nodes_pruned_;
+  checkpoint_->nodes_per_depth = nodes_per_depth_;
+  if (redo_current) {
+    checkpoint_->positions[depth]--;
+    checkpoint_->num_nodes_explored--;
+    checkpoint_->nodes_per_depth[depth]--;
+  }
+  checkpoint_->solutions = solution_statements_;
+  checkpoint_->Save();
+}
+
+
+static inline uint64_t RegisterBit(int reg) {
+  return (uint64_t) 1 << reg;
+}
+
+
+bool DepthFirstSearch::LeavesUnused(int depth, const Successor *successor) {
+  uint64_t reads = successor->IsOp1() ? RegisterBit(successor->GetOp1Arg()) :
+    RegisterBit(successor->GetOp2Arg1()) | RegisterBit(successor->GetOp2Arg2());
+  uint64_t before = depth > 0 ? unread_[depth - 1] : 0;
+  unread_[depth] = (before & ~reads) | RegisterBit(num_inputs_ + depth);
+
+  if (prune_unused_ == SearchOptions::kPruneUnchained) {
+    return depth > 0 && depth == max_program_length_ - 1 &&
+      (reads & RegisterBit(num_inputs_ + depth - 1)) == 0;
+  }
+  int remaining_steps = max_program_length_ - 1 - depth;
+  return prune_unused_ == SearchOptions::kPruneNonMinimal &&
+    __builtin_popcountll(unread_[depth]) - 1 > remaining_steps;
+}
+
+
+bool DepthFirstSearch::Solved() const {
+  return solved_;
+}
+
+
+const vector<string> &DepthFirstSearch::SolutionPrograms() const {
+  return solution_programs_;
+}
+
+
+const vector<vector<Successor> > &DepthFirstSearch::SolutionStatements() const {
+  return solution_statements_;
+}
+
+
+long DepthFirstSearch::NumNodesExplored() const {
+  return num_nodes_explored_;
+}
+
+
+long DepthFirstSearch::NumNodesPruned() const {
+  return num_nodes_pruned_;
+}
+
+
+const vector<long> &DepthFirstSearch::NodesPerDepth() const {
+  return nodes_per_depth_;
+}
+
+
+string DepthFirstSearch::DeepestPrefix() const {
+  return deepest_prefix_;
+}
+
+
+string DepthFirstSearch::StopPrefix() const {
+  return stop_prefix_;
+}
@@ -1,19 +1,145 @@
 #ifndef _DEPTH_FIRST_SEARCH__
 #define _DEPTH_FIRST_SEARCH__
 
-#include <queue>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
 
+#include "successor.h"
+
+class BackwardSubgoals;
+class FeasibilityCheck;
 class IOSet;
+class LeafEvaluator;
+class NodeScorer;
+class RangeAnalysis;
+class RankedOpTable;
+class SearchBudget;
+class SearchCheckpoint;
+class SearchStats;
+class SolutionSet;
+struct SearchOptions;
+
+using namespace std;
 
 class DepthFirstSearch {
+  /*
+   * DepthFirstSearch enumerates programs by extending the registers of an
+   * IOSet one statement at a time, trying the successors of every node in
+   * the order of a SuccessorIterator. Subtrees below solutions and below
+   * nodes rejected by the pruning checks of the options are skipped.
+   * Nodes at the last depth are checked by a LeafEvaluator, without
+   * writing their registers.
+   *
+   * With the prune_unused option, the search keeps the registers that no
+   * statement of the current program reads, as a bit mask per depth, and
+   * skips nodes that leave too many of them (see SearchOptions). A
+   * statement reads at most two registers and writes one, so each
+   * remaining statement lowers the number of unread registers by one at
+   * most, and a minimal program ends with only its output unread. With
+   * prune_rewrites, the iterators skip statements that are redundant with
+   * the statement producing their argument, and with prune_undefined,
+   * statements whose result is undefined in some example are skipped with
+   * their subtree.
+   *
+   * A node is identified by the positions of its statements in the
+   * enumeration of the iterators above it. Search() can be restricted to
+   * the subtree below such a prefix, and Partition() lists the prefixes of
+   * a given length, which splits a search into independent tasks.
+   * Counters and solutions accumulate over calls; io is left as it was
+   * given after every call.
+   *
+   * A search can save its path and counters to a SearchCheckpoint, and
+   * Resume() continues it from there, in this or another process.
+   */
  public:
-  DepthFirstSearch(IOSet *io);
+  // table, io, budget, solutions and subgoals are not owned; subgoals may
+  // be NULL.
+  DepthFirstSearch(const RankedOpTable *table, IOSet *io, int max_program_length,
+                   const SearchOptions &options, SearchBudget *budget,
+                   SolutionSet *solutions, BackwardSubgoals *subgoals);
   ~DepthFirstSearch();
 
+  // Counts applications, goal hits and pruning per op and depth, in
+  // INSTRUMENT_MODE builds; without it nothing is counted. Not owned, and
+  // not thread-safe: searches running concurrently need one each.
+  void SetStats(SearchStats *stats);
+  // Prints every distinct solution to log as soon as it is found.
+  void SetSolutionLog(ostream *log);
+  // Saves the state of Search and Resume to checkpoint whenever it is Due,
+  // and when the budget stops them. Not owned.
+  void SetCheckpoint(SearchCheckpoint *checkpoint);
+
+  // Searches the programs of up to search_length statements that start with
+  // the prefix `start` (all programs if it is empty). The nodes of the
+  // prefix are not counted and not checked again, except for the last one.
+  // With use_subgoals, stops at the first register matching a subgoal.
+  void Search(int search_length, const vector<int> &start, bool use_subgoals);
+  // Restores the counters and solutions of a checkpoint and continues the
+  // Search it was saved from after the last node it had explored.
+  void Resume(int search_length, const SearchCheckpoint &checkpoint, bool use_subgoals);
+
+  // Like Search(search_length, {}, use_subgoals), but stops at depth
+  // min(partition_length, search_length): the prefixes reaching it are
+  // appended to tasks instead of being explored, so that searching each of
+  // them explores the rest of the tree.
+  void Partition(int search_length, int partition_length, bool use_subgoals,
+                 vector<vector<int> > &tasks);
+
+  bool Solved() const;
+  // Solutions found so far, formatted by FormatProgram and as statements.
+  const vector<string> &SolutionPrograms() const;
+  const vector<vector<Successor> > &SolutionStatements() const;
+
+  long NumNodesExplored() const;
+  long NumNodesPruned() const;
+  const vector<long> &NodesPerDepth() const;
+  string DeepestPrefix() const;
+  // The program at which the last search stopped early, or "".
+  string StopPrefix() const;
 
  protected:
-  IOSet *io;
+  void Run(int search_length, const vector<int> &start, const vector<int> &resume,
+           bool use_subgoals, int partition_length, vector<vector<int> > *tasks);
+  // With redo_current, the node at depth is explored again on resuming.
+  void SaveCheckpoint(int depth, bool redo_current);
+  // Sets the unread registers after the statement at depth, and returns
+  // whether the node is skipped by prune_unused.
+  bool LeavesUnused(int depth, const Successor *successor);
+
+  const RankedOpTable *table_;
+  IOSet *io_;
+  int max_program_length_;
+  int num_inputs_;
+  SearchBudget *budget_;
+  SolutionSet *solutions_;
+  BackwardSubgoals *subgoals_;
+  SearchStats *stats_;
+  ostream *solution_log_;
+  SearchCheckpoint *checkpoint_;
+
+  NodeScorer *scorer_;
+  RangeAnalysis *ranges_;
+  FeasibilityCheck *feasibility_;
+  LeafEvaluator *leaf_evaluator_;
+  int prune_unused_;
+  bool prune_rewrites_;
+  bool prune_undefined_;
+  vector<uint64_t> unread_;
+  vector<SuccessorIterator *> iterators_;
+
+  bool solved_;
+  vector<string> solution_programs_;
+  vector<vector<Successor> > solution_statements_;
 
+  long num_nodes_explored_;
+  long num_nodes_pruned_;
+  vector<long> nodes_per_depth_;
+  vector<const Successor *> prefix_;
+  int deepest_depth_;
+  string deepest_prefix_;
+  string stop_prefix_;
 };
 
 #endif
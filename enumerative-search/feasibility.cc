@@ -0,0 +1,231 @@
+#include "feasibility.h"
+#include "datum.h"
+#include "io_set.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include <algorithm>
+#include <climits>
+
+
+// Value access returns for an out of range index.
+static const int kAccessDefault = -1000000;
+
+
+static bool ContainsValue(Datum *array, int value) {
+  for (int i = 0; i < array->Size(); i++) {
+    if (array->GetArrayElementValue(i) == value)  return true;
+  }
+  return false;
+}
+
+
+static bool IsSubsequence(Datum *sub, Datum *array) {
+  int j = 0;
+  for (int i = 0; i < array->Size() && j < sub->Size(); i++) {
+    if (array->GetArrayElementValue(i) == sub->GetArrayElementValue(j))  j++;
+  }
+  return j == sub->Size();
+}
+
+
+// Whether sub occurs in array starting at offset.
+static bool MatchesAt(Datum *sub, Datum *array, int offset) {
+  if (offset < 0 || offset + sub->Size() > array->Size())  return false;
+  for (int i = 0; i < sub->Size(); i++) {
+    if (array->GetArrayElementValue(offset + i) != sub->GetArrayElementValue(i))  return false;
+  }
+  return true;
+}
+
+
+FeasibilityCheck::FeasibilityCheck(const RankedOpTable *table, IOSet *io) {
+  for (auto &successor : table->Successors()) {
+    string name = successor.Name();
+    OpKind kind = kUnknown;
+    if (name == "increment")  kind = kIncrement;
+    else if (name == "decrement")  kind = kDecrement;
+    else if (name == "arr_min" || name == "arr_max" || name == "arr_head" || name == "arr_last")  kind = kSelect;
+    else if (name == "arr_sum")  kind = kSum;
+    else if (name.compare(0, 6, "count_") == 0)  kind = kCount;
+    else if (name == "access")  kind = kAccess;
+    else if (name.compare(0, 4, "map_") == 0)  kind = kMap;
+    else if (name == "sort")  kind = kSort;
+    else if (name == "reverse")  kind = kReverse;
+    else if (name == "filter_is_pos")  kind = kFilterPos;
+    else if (name == "filter_is_neg")  kind = kFilterNeg;
+    else if (name == "filter_is_odd")  kind = kFilterOdd;
+    else if (name == "filter_is_even")  kind = kFilterEven;
+    else if (name == "scanl_max")  kind = kScanMax;
+    else if (name == "scanl_min")  kind = kScanMin;
+    else if (name.compare(0, 6, "scanl_") == 0)  kind = kScan;
+    else if (name == "take")  kind = kTake;
+    else if (name == "drop")  kind = kDrop;
+    else if (name.compare(0, 8, "zipwith_") == 0)  kind = kZip;
+
+    ops_.push_back(kind);
+    op_result_types_.push_back(successor.ResultType());
+    if (successor.IsOp1()) {
+      op_arg_types_.push_back(make_pair(successor.GetOp1ArgType(), successor.GetOp1ArgType()));
+      op_num_args_.push_back(1);
+    } else {
+      op_arg_types_.push_back(make_pair(successor.GetOp2Arg1Type(), successor.GetOp2Arg2Type()));
+      op_num_args_.push_back(2);
+    }
+  }
+
+  for (int i = 0; i < io->Size(); i++) {
+    Datum *target = io->GetOutput(i);
+    targets_.push_back(target);
+    vector<int> sorted;
+    if (target->Type() == Array)  sorted = *target->GetValues();
+    sort(sorted.begin(), sorted.end());
+    sorted_targets_.push_back(sorted);
+  }
+}
+
+
+bool FeasibilityCheck::Feasible(IOSet *io, int remaining_steps) const {
+  if (remaining_steps == 1)  return OneStepFeasible(io);
+  if (remaining_steps == 2)  return TwoStepsFeasible(io);
+  return true;
+}
+
+
+bool FeasibilityCheck::Possible(OpKind kind, Datum *arg1, Datum *arg2, int example_idx) const {
+  Datum *target = targets_[example_idx];
+  const vector<int> &sorted_target = sorted_targets_[example_idx];
+
+  switch (kind) {
+  case kIncrement:
+    return target->GetIntValue() == arg1->GetIntValue() + 1;
+  case kDecrement:
+    return target->GetIntValue() == arg1->GetIntValue() - 1;
+  case kSelect:
+    // Empty arrays give 0 (head, last), INT_MAX (min) or INT_MIN (max).
+    if (arg1->Size() == 0) {
+      int t = target->GetIntValue();
+      return t == 0 || t == INT_MAX || t == INT_MIN;
+    }
+    return ContainsValue(arg1, target->GetIntValue());
+  case kCount:
+    return target->GetIntValue() >= 0 && target->GetIntValue() <= arg1->Size();
+  case kAccess:
+    return target->GetIntValue() == kAccessDefault || ContainsValue(arg2, target->GetIntValue());
+
+  case kMap:
+  case kScan:
+    if (arg1->Size() != target->Size())  return false;
+    return kind == kMap || target->Size() == 0 ||
+      target->GetArrayElementValue(0) == arg1->GetArrayElementValue(0);
+  case kScanMax:
+  case kScanMin:
+    if (arg1->Size() != target->Size())  return false;
+    if (target->Size() == 0)  return true;
+    if (target->GetArrayElementValue(0) != arg1->GetArrayElementValue(0))  return false;
+    for (int i = 1; i < target->Size(); i++) {
+      int step = target->GetArrayElementValue(i) - target->GetArrayElementValue(i - 1);
+      if (kind == kScanMax ? step < 0 : step > 0)  return false;
+    }
+    return true;
+  case kSort:
+    if (*target->GetValues() != sorted_target)  return false;
+    // fall through
+  case kReverse: {
+    if (arg1->Size() != target->Size())  return false;
+    vector<int> sorted = *arg1->GetValues();
+    sort(sorted.begin(), sorted.end());
+    return sorted == sorted_target;
+  }
+  case kFilterPos:
+  case kFilterNeg:
+  case kFilterOdd:
+  case kFilterEven:
+    for (int i = 0; i < target->Size(); i++) {
+      int t = target->GetArrayElementValue(i);
+      if ((kind == kFilterPos && t <= 0) || (kind == kFilterNeg && t >= 0) ||
+          (kind == kFilterOdd && t % 2 == 0) || (kind == kFilterEven && t % 2 != 0)) {
+        return false;
+      }
+    }
+    return IsSubsequence(target, arg1);
+  case kTake:
+    return MatchesAt(target, arg2, 0);
+  case kDrop:
+    return target->Size() == 0 || MatchesAt(target, arg2, arg2->Size() - target->Size());
+  case kZip:
+    return min(arg1->Size(), arg2->Size()) == target->Size();
+
+  default:
+    return true;
+  }
+}
+
+
+bool FeasibilityCheck::OneStepFeasible(IOSet *io) const {
+  ProgramState *ps = io->GetInputs(0);
+  int num_registers = ps->NumUsed();
+  DatumType target_type = targets_[0]->Type();
+
+  for (int k = 0; k < ops_.size(); k++) {
+    if (op_result_types_[k] != target_type)  continue;
+    if (ops_[k] == kUnknown || ops_[k] == kSum)  return true;
+
+    for (int j1 = 0; j1 < num_registers; j1++) {
+      if (ps->GetDatumType(j1) != op_arg_types_[k].first)  continue;
+      for (int j2 = 0; j2 < num_registers; j2++) {
+        if (op_num_args_[k] == 1 && j2 > 0)  break;
+        if (op_num_args_[k] == 2 && ps->GetDatumType(j2) != op_arg_types_[k].second)  continue;
+
+        bool possible = true;
+        for (int i = 0; i < io->Size() && possible; i++) {
+          ProgramState *example = io->GetInputs(i);
+          possible = Possible(ops_[k], example->GetDatum(j1),
+                              op_num_args_[k] == 2 ? example->GetDatum(j2) : NULL, i);
+        }
+        if (possible)  return true;
+      }
+    }
+  }
+  return false;
+}
+
+
+// No op makes an array longer than its array arguments. Ops that keep the
+// length of an argument (maps, sort, reverse, scans, and zips, whose result
+// is as long as the shorter argument) produce lengths that are already
+// present; filters, take and drop produce any length up to the longest.
+bool FeasibilityCheck::TwoStepsFeasible(IOSet *io) const {
+  if (targets_[0]->Type() != Array)  return true;
+
+  bool keeps_length = false, shortens = false;
+  for (int k = 0; k < ops_.size(); k++) {
+    if (op_result_types_[k] != Array)  continue;
+    switch (ops_[k]) {
+    case kMap: case kSort: case kReverse: case kScan: case kScanMax: case kScanMin: case kZip:
+      keeps_length = true;
+      break;
+    case kFilterPos: case kFilterNeg: case kFilterOdd: case kFilterEven: case kTake: case kDrop:
+      shortens = true;
+      break;
+    default:
+      return true;
+    }
+  }
+
+  for (int i = 0; i < io->Size(); i++) {
+    ProgramState *ps = io->GetInputs(i);
+    int target_length = targets_[i]->Size();
+    int max_length = -1;
+    bool present = false;
+    for (int j = 0; j < ps->NumUsed(); j++) {
+      if (ps->GetDatumType(j) != Array)  continue;
+      max_length = max(max_length, ps->GetDatum(j)->Size());
+      present = present || ps->GetDatum(j)->Size() == target_length;
+    }
+    // Lengths produced by the last statement, from registers or from an
+    // intermediate result of the same kind.
+    bool reachable = (keeps_length && present) || (shortens && target_length <= max_length);
+    if (!reachable)  return false;
+  }
+  return true;
+}
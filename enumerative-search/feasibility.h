@@ -0,0 +1,64 @@
+#ifndef _FEASIBILITY__
+#define _FEASIBILITY__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "definitions.h"
+
+class Datum;
+class IOSet;
+class RankedOpTable;
+
+using namespace std;
+
+class FeasibilityCheck {
+  /*
+   * FeasibilityCheck tests necessary conditions for reaching the targets in
+   * the last one or two statements of a program, without running any op.
+   *
+   * With one statement left, some ranked op must be able to produce the
+   * target of every example from the same argument registers: length
+   * preserving ops need an argument exactly as long as an array target,
+   * sort and reverse one with the same elements, filters, take and drop one
+   * that contains the target as a subsequence, prefix or suffix, and ops
+   * selecting an element one that contains an int target.
+   *
+   * With two statements left, the length of an array target must be one the
+   * ranked ops can produce in two steps.
+   */
+ public:
+  FeasibilityCheck(const RankedOpTable *table, IOSet *io);
+
+  // False if no program of remaining_steps more statements can produce the
+  // targets of io. Always true for more than two remaining steps.
+  bool Feasible(IOSet *io, int remaining_steps) const;
+
+ protected:
+  enum OpKind {
+    kUnknown, kIncrement, kDecrement, kSelect, kSum, kCount, kAccess,
+    kMap, kSort, kReverse, kFilterPos, kFilterNeg, kFilterOdd, kFilterEven,
+    kScan, kScanMax, kScanMin, kTake, kDrop, kZip
+  };
+
+  bool OneStepFeasible(IOSet *io) const;
+  bool TwoStepsFeasible(IOSet *io) const;
+
+  // Whether op could map argument registers arg1 (and arg2) of an example
+  // to its target.
+  bool Possible(OpKind kind, Datum *arg1, Datum *arg2, int example_idx) const;
+
+  // Kind, result type, argument types and number of arguments of every
+  // ranked op.
+  vector<OpKind> ops_;
+  vector<DatumType> op_result_types_;
+  vector<pair<DatumType, DatumType> > op_arg_types_;
+  vector<int> op_num_args_;
+
+  // Targets, and sorted copies of array targets.
+  vector<Datum *> targets_;
+  vector<vector<int> > sorted_targets_;
+};
+
+#endif
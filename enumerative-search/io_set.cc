@@ -2,6 +2,7 @@
 #include "program_state.h"
 #include "datum.h"
 #include "utils.h"
+#include "line_index.h"
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -42,12 +43,51 @@ IOSet::IOSet(string dir_name, int problem_idx, int num_examples_per_program) {
 
   inputs_.assign(inputs.begin(), inputs.end());
   outputs_.assign(outputs.begin(), outputs.end());
+  Init();
 }
 
 
 IOSet::IOSet(vector<ProgramState *> &inputs, vector<Datum *> &outputs) {
   inputs_.assign(inputs.begin(), inputs.end());
   outputs_.assign(outputs.begin(), outputs.end());
+  Init();
+}
+
+
+// Whether two examples have the same inputs and target.
+static bool SameExample(ProgramState *ps1, Datum *output1, ProgramState *ps2, Datum *output2) {
+  if (ps1->NumUsed() != ps2->NumUsed() || *output1 != *output2)  return false;
+  for (int i = 0; i < ps1->NumUsed(); i++) {
+    if (*ps1->GetDatum(i) != *ps2->GetDatum(i))  return false;
+  }
+  return true;
+}
+
+
+void IOSet::Init() {
+  int num_kept = 0;
+  for (int i = 0; i < inputs_.size(); i++) {
+    bool duplicate = false;
+    for (int j = 0; j < num_kept && !duplicate; j++) {
+      duplicate = SameExample(inputs_[i], outputs_[i], inputs_[j], outputs_[j]);
+    }
+    if (duplicate) {
+      delete inputs_[i];
+      delete outputs_[i];
+    } else {
+      inputs_[num_kept] = inputs_[i];
+      outputs_[num_kept] = outputs_[i];
+      num_kept++;
+    }
+  }
+  inputs_.resize(num_kept);
+  outputs_.resize(num_kept);
+
+  for (int i = 0; i < num_kept; i++)  check_order_.push_back(i);
+  stops_.assign(num_kept + 1, 0);
+  num_checks_ = 0;
+  num_compared_.assign(num_kept, 0);
+  num_rejected_.assign(num_kept, 0);
 }
 
 
@@ -88,15 +128,56 @@ void IOSet::Pop() {
 
 
 bool IOSet::IsSolved() {
-  for (int i = 0; i < inputs_.size(); i++) {
-    ProgramState *ps = inputs_[i];
-    Datum *target = outputs_[i];
-    if (*ps->GetLastDatum() != *target)  return false;
+  for (int position = 0; position < check_order_.size(); position++) {
+    int i = check_order_[position];
+    if (*inputs_[i]->GetLastDatum() != *outputs_[i]) {
+      RecordCheck(position);
+      return false;
+    }
   }
+  RecordCheck(check_order_.size());
   return true;
 }
 
 
+bool IOSet::LastDefined() const {
+  for (auto &ps : inputs_) {
+    if (!ps->GetLastDatum()->Defined())  return false;
+  }
+  return true;
+}
+
+
+const vector<int> &IOSet::CheckOrder() const {
+  return check_order_;
+}
+
+
+void IOSet::Reorder() {
+  // The example at a position was compared by every goal test that stopped
+  // there or later.
+  long num_reached = 0;
+  for (int position = check_order_.size(); position >= 0; position--) {
+    num_reached += stops_[position];
+    if (position < check_order_.size()) {
+      int i = check_order_[position];
+      num_compared_[i] += num_reached;
+      num_rejected_[i] += stops_[position];
+    }
+    stops_[position] = 0;
+  }
+
+  vector<double> rate(check_order_.size());
+  for (int i = 0; i < rate.size(); i++) {
+    rate[i] = num_compared_[i] > 0 ? num_rejected_[i] / num_compared_[i] : 0;
+    num_compared_[i] /= 2;
+    num_rejected_[i] /= 2;
+  }
+  stable_sort(check_order_.begin(), check_order_.end(),
+              [&rate](int i, int j) { return rate[i] > rate[j]; });
+}
+
+
 void IOSet::LoadData(string types_filename, string data_filename, int problem_idx,
                      int num_examples_per_program, vector<ProgramState *> &result) {
 
@@ -113,19 +194,14 @@ void IOSet::LoadTypes(string filename, int problem_idx, vector<DatumType> &resul
 
   ifstream types_file;
   types_file.open(filename);
+  CHECK(types_file.is_open(), "Failed to open file " + filename);
 
-  string line;
-  for (int i = 0; i < problem_idx + 1; i++)  getline(types_file, line);
-
-  stringstream ss;
-  ss << line;
+  LineIndex index(filename);
+  types_file.seekg(index.LineOffset(problem_idx));
 
-  string type;
-  while (ss >> type) {
-    if (type == "Array")  result.push_back(Array);
-    else if (type == "Int")  result.push_back(Int);
-    else CHECK(false, "Unexpected type " + type);
-  }
+  string line;
+  getline(types_file, line);
+  CHECK(ParseTypes(line, result), "Unexpected type in " + line);
 }
 
 
@@ -133,53 +209,69 @@ void IOSet::LoadValues(string filename, int problem_idx, int examples_per_progra
                        vector<DatumType> &types, vector<ProgramState *> &result) {
   ifstream file;
   file.open(filename);
+  CHECK(file.is_open(), "Failed to open file " + filename);
+
+  LineIndex index(filename);
+  file.seekg(index.LineOffset(problem_idx * examples_per_program));
 
   string line;
-  for (int i = 0; i < problem_idx; i++) {
-    for (int j = 0; j < examples_per_program; j++) {
-      getline(file, line);
-    }
-  }
 
   for (int j = 0; j < examples_per_program; j++) {
-    // read arguments into a vector<vector<int> > data structure
     getline(file, line);
+    ProgramState *ps = ParseValues(line, types);
+    // make sure the read was consistent with types data loaded earlier
+    CHECK_NOT_NULL(ps, "inconsistency in values and types data");
+    result.push_back(ps);
+  }
+}
 
-    stringstream ss;
-    ss << line;
 
-    string element;
-    int argument_idx = 0;
-    vector<vector<int> > values(1);
-    while (ss >> element) {
-      if (element == "|") {
-        argument_idx++;
-        values.push_back(vector<int>());
+bool IOSet::ParseTypes(string line, vector<DatumType> &types) {
+  types.clear();
+  stringstream ss(line);
+  string type;
+  while (ss >> type) {
+    if (type == "Array")  types.push_back(Array);
+    else if (type == "Int")  types.push_back(Int);
+    else return false;
+  }
+  return true;
+}
 
-      } else {
-        int value = atoi(element.c_str());
-        values[argument_idx].push_back(value);
-      }
+
+ProgramState *IOSet::ParseValues(string line, const vector<DatumType> &types) {
+  // read arguments into a vector<vector<int> > data structure
+  stringstream ss(line);
+  string element;
+  int argument_idx = 0;
+  vector<vector<int> > values(1);
+  while (ss >> element) {
+    if (element == "|") {
+      argument_idx++;
+      values.push_back(vector<int>());
+    } else {
+      char *end;
+      long value = strtol(element.c_str(), &end, 10);
+      if (*end != '\0')  return NULL;
+      values[argument_idx].push_back(value);
     }
+  }
 
-    // make sure the read was consistent with types data loaded earlier
-    CHECK_EQ(values.size(), types.size(), "inconsistency in values and types data");
+  if (values.size() != types.size())  return NULL;
+  for (int i = 0; i < values.size(); i++) {
+    if (types[i] == Int && values[i].size() != 1)  return NULL;
+  }
 
-    // construct ProgramState object for this example
-    vector<Datum *> data;
-    for (int i = 0; i < values.size(); i++) {
-      if (types[i] == Array) {
-        data.push_back(new Datum(values[i]));
-      } else {
-        data.push_back(new Datum(values[i][0]));
-      }
+  // construct ProgramState object for this example
+  vector<Datum *> data;
+  for (int i = 0; i < values.size(); i++) {
+    if (types[i] == Array) {
+      data.push_back(new Datum(values[i]));
+    } else {
+      data.push_back(new Datum(values[i][0]));
     }
-    ProgramState *ps = new ProgramState(data);
-    // cout << "Loaded program state" << endl;
-    // cout << *ps << endl;
-
-    result.push_back(ps);
   }
+  return new ProgramState(data);
 }
 
 
@@ -14,6 +14,19 @@ class Datum;
 using namespace std;
 
 class IOSet {
+  /*
+   * IOSet holds the examples of a problem: the registers of every example
+   * and its target output. Examples that repeat an earlier one are dropped
+   * when the set is built.
+   *
+   * The goal test compares the examples with their targets one at a time
+   * and stops at the first that differs, so it is fastest when the example
+   * most likely to differ goes first. The set counts, per example, how many
+   * of the programs compared with it it rejected, and every
+   * kReorderInterval goal tests sorts CheckOrder() by that rate. Counts are
+   * halved at every reordering so that the order follows the part of the
+   * tree being searched.
+   */
  public:
   IOSet(string dir_name, int problem_idx, int num_examples_per_program);
   IOSet(vector<ProgramState *> &inputs, vector<Datum *> &outputs);
@@ -27,11 +40,45 @@ class IOSet {
   void ApplyOp2(DatumOp2 op, int arg1_idx, int arg2_idx);
   void Pop();
   bool IsSolved();
+  // Whether the last register is defined (see Datum) in every example.
+  bool LastDefined() const;
+
+  // The order in which to compare examples with their targets.
+  const vector<int> &CheckOrder() const;
+  // Records a goal test that stopped at position (in CheckOrder) of a
+  // differing example, or at Size() if every example matched.
+  inline void RecordCheck(int position) {
+    stops_[position]++;
+    if (++num_checks_ % kReorderInterval == 0)  Reorder();
+  }
+
+  static const long kReorderInterval = 4096;
+
+  // Parses a line of a types file such as "Int Array". Returns false if it
+  // names an unknown type.
+  static bool ParseTypes(string line, vector<DatumType> &types);
+  // Parses a line of a values file into a ProgramState with one register
+  // per type. Returns NULL if the values do not match the types.
+  static ProgramState *ParseValues(string line, const vector<DatumType> &types);
 
  protected:
   vector<ProgramState *> inputs_;
   vector<Datum *> outputs_;
 
+  vector<int> check_order_;
+  // By position in check_order_, goal tests that stopped there since the
+  // last reordering.
+  vector<long> stops_;
+  long num_checks_;
+  // By example, decayed counts of the goal tests that compared it and that
+  // it rejected.
+  vector<double> num_compared_;
+  vector<double> num_rejected_;
+
+  // Drops examples equal to an earlier one, and sets up the check order.
+  void Init();
+  void Reorder();
+
   void LoadData(string types_filename, string data_filename, int problem_idx,
                 int num_examples_per_program, /*out*/vector<ProgramState *> &result);
 
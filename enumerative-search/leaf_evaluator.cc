@@ -0,0 +1,255 @@
+#include "leaf_evaluator.h"
+#include "io_set.h"
+#include "ops.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include "successor.h"
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <set>
+#include <string>
+
+
+// Value access returns for an out of range index.
+static const int kAccessDefault = -1000000;
+
+
+// The values of a datum, unchecked; an Int holds its value at index 0.
+static inline const vector<int> &Values(Datum *d) {
+  return *d->GetValues();
+}
+
+
+/*
+ *
+ * Array to int ops
+ *
+ */
+
+static bool MatchMax(Datum *arg1, Datum *arg2, Datum *target) {
+  int result = INT_MIN;
+  for (int x : Values(arg1))  result = max(result, x);
+  return result == Values(target)[0];
+}
+
+
+static bool MatchMin(Datum *arg1, Datum *arg2, Datum *target) {
+  int result = INT_MAX;
+  for (int x : Values(arg1))  result = min(result, x);
+  return result == Values(target)[0];
+}
+
+
+static bool MatchHead(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x = Values(arg1);
+  return (x.empty() ? 0 : x.front()) == Values(target)[0];
+}
+
+
+static bool MatchLast(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x = Values(arg1);
+  return (x.empty() ? 0 : x.back()) == Values(target)[0];
+}
+
+
+static bool MatchSum(Datum *arg1, Datum *arg2, Datum *target) {
+  int total = 0;
+  for (int x : Values(arg1))  total += x;
+  return total == Values(target)[0];
+}
+
+
+template <IntBoolLambda f>
+static bool MatchCount(Datum *arg1, Datum *arg2, Datum *target) {
+  int count = 0;
+  for (int x : Values(arg1)) {
+    if (f(x))  count++;
+  }
+  return count == Values(target)[0];
+}
+
+
+static bool MatchAccess(Datum *arg1, Datum *arg2, Datum *target) {
+  int offset = Values(arg1)[0];
+  const vector<int> &x = Values(arg2);
+  int result = offset >= 0 && offset < x.size() ? x[offset] : kAccessDefault;
+  return result == Values(target)[0];
+}
+
+
+/*
+ *
+ * Array to array ops
+ *
+ */
+
+template <IntIntLambda f>
+static bool MatchMap(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x = Values(arg1);
+  const vector<int> &y = Values(target);
+  if (x.size() != y.size())  return false;
+  for (int i = 0; i < x.size(); i++) {
+    if (f(x[i]) != y[i])  return false;
+  }
+  return true;
+}
+
+
+template <IntBoolLambda f>
+static bool MatchFilter(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x = Values(arg1);
+  const vector<int> &y = Values(target);
+  int j = 0;
+  for (int i = 0; i < x.size(); i++) {
+    if (!f(x[i]))  continue;
+    if (j == y.size() || x[i] != y[j])  return false;
+    j++;
+  }
+  return j == y.size();
+}
+
+
+template <IntIntIntLambda f>
+static bool MatchScanl(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x = Values(arg1);
+  const vector<int> &y = Values(target);
+  if (x.size() != y.size())  return false;
+  if (x.empty())  return true;
+  int running_val = x[0];
+  if (running_val != y[0])  return false;
+  for (int i = 1; i < x.size(); i++) {
+    running_val = f(running_val, x[i]);
+    if (running_val != y[i])  return false;
+  }
+  return true;
+}
+
+
+static bool MatchReverse(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x = Values(arg1);
+  const vector<int> &y = Values(target);
+  if (x.size() != y.size())  return false;
+  for (int i = 0, n = x.size(); i < n; i++) {
+    if (x[n - 1 - i] != y[i])  return false;
+  }
+  return true;
+}
+
+
+// Sorting cannot be streamed, but most targets are not sorted, or do not
+// have the same length as the argument, which is checked first.
+static bool MatchSort(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x = Values(arg1);
+  const vector<int> &y = Values(target);
+  if (x.size() != y.size() || !is_sorted(y.begin(), y.end()))  return false;
+  static thread_local vector<int> sorted;
+  sorted.assign(x.begin(), x.end());
+  sort(sorted.begin(), sorted.end());
+  return sorted == y;
+}
+
+
+static bool MatchTake(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x = Values(arg2);
+  const vector<int> &y = Values(target);
+  int result_size = max(min(Values(arg1)[0], (int) x.size()), 0);
+  return result_size == y.size() && equal(y.begin(), y.end(), x.begin());
+}
+
+
+static bool MatchDrop(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x = Values(arg2);
+  const vector<int> &y = Values(target);
+  int offset = Values(arg1)[0];
+  int result_size = offset >= 0 ? max((int) x.size() - offset, 0) : 0;
+  return result_size == y.size() && equal(y.begin(), y.end(), x.end() - result_size);
+}
+
+
+template <IntIntIntLambda f>
+static bool MatchZipWith(Datum *arg1, Datum *arg2, Datum *target) {
+  const vector<int> &x1 = Values(arg1);
+  const vector<int> &x2 = Values(arg2);
+  const vector<int> &y = Values(target);
+  if (min(x1.size(), x2.size()) != y.size())  return false;
+  for (int i = 0; i < y.size(); i++) {
+    if (f(x1[i], x2[i]) != y[i])  return false;
+  }
+  return true;
+}
+
+
+LeafEvaluator::LeafEvaluator(const RankedOpTable *table, IOSet *io, bool reject_undefined) :
+  output_type_(io->GetOutput(0)->Type()),
+  reject_undefined_(reject_undefined)
+{
+  static const map<string, Match> matches = {
+    {"arr_max", MatchMax}, {"arr_min", MatchMin}, {"arr_head", MatchHead},
+    {"arr_last", MatchLast}, {"arr_sum", MatchSum},
+    {"count_is_pos", MatchCount<is_pos_lambda>}, {"count_is_neg", MatchCount<is_neg_lambda>},
+    {"count_is_odd", MatchCount<is_odd_lambda>}, {"count_is_even", MatchCount<is_even_lambda>},
+    {"map_increment", MatchMap<increment_lambda>}, {"map_decrement", MatchMap<decrement_lambda>},
+    {"map_mult2", MatchMap<mult2_lambda>}, {"map_div2", MatchMap<div2_lambda>},
+    {"map_negate", MatchMap<negate_lambda>}, {"map_sqr", MatchMap<sqr_lambda>},
+    {"map_mult3", MatchMap<mult3_lambda>}, {"map_div3", MatchMap<div3_lambda>},
+    {"map_mult4", MatchMap<mult4_lambda>}, {"map_div4", MatchMap<div4_lambda>},
+    {"filter_is_pos", MatchFilter<is_pos_lambda>}, {"filter_is_neg", MatchFilter<is_neg_lambda>},
+    {"filter_is_odd", MatchFilter<is_odd_lambda>}, {"filter_is_even", MatchFilter<is_even_lambda>},
+    {"sort", MatchSort}, {"reverse", MatchReverse},
+    {"scanl_add", MatchScanl<add_lambda>}, {"scanl_subtract", MatchScanl<subtract_lambda>},
+    {"scanl_mult", MatchScanl<mult_lambda>}, {"scanl_max", MatchScanl<max_lambda>},
+    {"scanl_min", MatchScanl<min_lambda>},
+    {"access", MatchAccess}, {"take", MatchTake}, {"drop", MatchDrop},
+    {"zipwith_add", MatchZipWith<add_lambda>}, {"zipwith_subtract", MatchZipWith<subtract_lambda>},
+    {"zipwith_mult", MatchZipWith<mult_lambda>}, {"zipwith_max", MatchZipWith<max_lambda>},
+    {"zipwith_min", MatchZipWith<min_lambda>}};
+  // The ops of ops.cc that clear Datum::Defined when a precondition fails.
+  static const set<string> partial = {
+    "arr_max", "arr_min", "arr_head", "arr_last", "access", "take", "drop"};
+
+  for (int id = 0; id < table->NumOps(); id++) {
+    string name = table->Op(id).Name();
+    auto it = matches.find(name);
+    bool run_kernel = it == matches.end() || (reject_undefined && partial.count(name) > 0);
+    matches_.push_back(run_kernel ? NULL : it->second);
+  }
+}
+
+
+bool LeafEvaluator::Solves(IOSet *io, const Successor *successor) {
+  if (successor->ResultType() != output_type_)  return false;
+
+  int id = successor->Id();
+  Match match = id >= 0 && id < matches_.size() ? matches_[id] : NULL;
+  bool op1 = successor->IsOp1();
+  int arg1 = op1 ? successor->GetOp1Arg() : successor->GetOp2Arg1();
+  int arg2 = op1 ? -1 : successor->GetOp2Arg2();
+
+  const vector<int> &order = io->CheckOrder();
+  for (int position = 0; position < order.size(); position++) {
+    ProgramState *ps = io->GetInputs(order[position]);
+    Datum *target = io->GetOutput(order[position]);
+    Datum *d1 = ps->GetDatum(arg1);
+    Datum *d2 = op1 ? NULL : ps->GetDatum(arg2);
+    bool matched;
+    if (match != NULL) {
+      matched = match(d1, d2, target);
+    } else {
+      if (op1) {
+        scratch_.SetDefined(d1->Defined());
+        successor->GetOp1()(d1, &scratch_);
+      } else {
+        scratch_.SetDefined(d1->Defined() && d2->Defined());
+        successor->GetOp2()(d1, d2, &scratch_);
+      }
+      matched = scratch_ == *target && (scratch_.Defined() || !reject_undefined_);
+    }
+    if (!matched) {
+      io->RecordCheck(position);
+      return false;
+    }
+  }
+  io->RecordCheck(order.size());
+  return true;
+}
@@ -0,0 +1,51 @@
+#ifndef _LEAF_EVALUATOR__
+#define _LEAF_EVALUATOR__
+
+#include <vector>
+
+#include "datum.h"
+#include "definitions.h"
+
+class IOSet;
+class RankedOpTable;
+class Successor;
+
+using namespace std;
+
+class LeafEvaluator {
+  /*
+   * LeafEvaluator tells whether a successor solves an IOSet without
+   * applying it, for the nodes at the last depth of a search, which are
+   * most of them. For every example, in the IOSet's CheckOrder, the
+   * result of the op is computed an element at a time and compared with
+   * the target as it goes, stopping at the first difference; nothing is
+   * written to the registers. Ops that cannot produce the type of the
+   * targets are rejected without looking at any example, and ops without a
+   * streaming comparison fall back to running their kernel into a scratch
+   * Datum.
+   *
+   * The comparisons follow the kernels of ops.cc exactly (including the
+   * results for empty arrays and out of range indices), so that Solves()
+   * agrees with ApplySuccessor followed by IOSet::IsSolved. With
+   * reject_undefined, a result that is not defined (see Datum) in some
+   * example does not solve it: ops that can leave it undefined then run
+   * their kernel instead.
+   */
+ public:
+  LeafEvaluator(const RankedOpTable *table, IOSet *io, bool reject_undefined);
+
+  bool Solves(IOSet *io, const Successor *successor);
+
+  // Whether op applied to arg1 (and arg2, NULL for ops of one argument)
+  // gives target.
+  typedef bool (*Match)(Datum *arg1, Datum *arg2, Datum *target);
+
+ protected:
+  // By op id; NULL for ops without a streaming comparison.
+  vector<Match> matches_;
+  DatumType output_type_;
+  bool reject_undefined_;
+  Datum scratch_;
+};
+
+#endif
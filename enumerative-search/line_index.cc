@@ -0,0 +1,126 @@
+#include "line_index.h"
+#include "utils.h"
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+
+static const char kLineIndexMagic[8] = {'D', 'C', 'L', 'I', 'D', 'X', '1', '\0'};
+
+struct LineIndexHeader {
+  char magic[8];
+  uint64_t file_size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  uint64_t num_lines;
+};
+
+
+LineIndex::LineIndex(string data_filename) :
+  data_filename_(data_filename),
+  index_filename_(data_filename + ".idx"),
+  file_size_(0), mtime_sec_(0), mtime_nsec_(0), num_lines_(0),
+  index_file_(NULL)
+{
+  struct stat st;
+  CHECK(stat(data_filename_.c_str(), &st) == 0, "Failed to stat file " + data_filename_);
+  file_size_ = st.st_size;
+  mtime_sec_ = st.st_mtim.tv_sec;
+  mtime_nsec_ = st.st_mtim.tv_nsec;
+
+  if (!OpenSidecar()) {
+    Build();
+    WriteSidecar();
+  }
+}
+
+
+LineIndex::~LineIndex() {
+  if (index_file_ != NULL)  fclose(index_file_);
+}
+
+
+long LineIndex::LineOffset(int line) {
+  if (line < 0 || (uint64_t) line >= num_lines_)  return file_size_;
+
+  if (index_file_ == NULL)  return offsets_[line];
+
+  uint64_t offset;
+  fseek(index_file_, sizeof(LineIndexHeader) + line * sizeof(uint64_t), SEEK_SET);
+  CHECK_EQ(fread(&offset, sizeof(offset), 1, index_file_), 1,
+           "Failed to read line offset from " + index_filename_);
+  return offset;
+}
+
+
+// Returns true if a sidecar matching the current data file was found.
+bool LineIndex::OpenSidecar() {
+  FILE *f = fopen(index_filename_.c_str(), "rb");
+  if (f == NULL)  return false;
+
+  LineIndexHeader header;
+  bool fresh = fread(&header, sizeof(header), 1, f) == 1 &&
+    memcmp(header.magic, kLineIndexMagic, sizeof(kLineIndexMagic)) == 0 &&
+    header.file_size == file_size_ &&
+    header.mtime_sec == mtime_sec_ &&
+    header.mtime_nsec == mtime_nsec_;
+
+  if (!fresh) {
+    fclose(f);
+    return false;
+  }
+  num_lines_ = header.num_lines;
+  index_file_ = f;
+  return true;
+}
+
+
+void LineIndex::Build() {
+  FILE *f = fopen(data_filename_.c_str(), "rb");
+  CHECK_NOT_NULL(f, "Failed to open file " + data_filename_);
+
+  offsets_.clear();
+  vector<char> buffer(1 << 20);
+  uint64_t pos = 0;
+  bool at_line_start = true;
+  size_t n;
+  while ((n = fread(&buffer[0], 1, buffer.size(), f)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      if (at_line_start)  offsets_.push_back(pos + i);
+      at_line_start = (buffer[i] == '\n');
+    }
+    pos += n;
+  }
+  fclose(f);
+  num_lines_ = offsets_.size();
+}
+
+
+// Best effort: the data directory may not be writable, in which case the
+// in-memory offsets are used for this run only. The sidecar is written to
+// a temporary file, unique to the thread, and renamed into place so that
+// concurrent loaders never see a partial index.
+void LineIndex::WriteSidecar() {
+  string tmp_filename = index_filename_ + ".tmp" + to_string(getpid()) + "." +
+    to_string(hash<thread::id>()(this_thread::get_id()));
+  FILE *f = fopen(tmp_filename.c_str(), "wb");
+  if (f == NULL)  return;
+
+  LineIndexHeader header;
+  memcpy(header.magic, kLineIndexMagic, sizeof(kLineIndexMagic));
+  header.file_size = file_size_;
+  header.mtime_sec = mtime_sec_;
+  header.mtime_nsec = mtime_nsec_;
+  header.num_lines = num_lines_;
+
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+  if (ok && num_lines_ > 0) {
+    ok = fwrite(&offsets_[0], sizeof(uint64_t), num_lines_, f) == num_lines_;
+  }
+  ok = (fclose(f) == 0) && ok;
+
+  if (!ok || rename(tmp_filename.c_str(), index_filename_.c_str()) != 0) {
+    unlink(tmp_filename.c_str());
+  }
+}
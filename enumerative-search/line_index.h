@@ -0,0 +1,49 @@
+#ifndef _LINE_INDEX__
+#define _LINE_INDEX__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class LineIndex {
+  /*
+   * LineIndex maps line numbers of a text data file to byte offsets, so
+   * that loaders can seek straight to the lines of one problem instead of
+   * skipping all earlier lines with getline.
+   *
+   * The offsets are cached next to the data file in FILENAME.idx. The
+   * sidecar records the size and mtime of the data file it was built
+   * from, and is rebuilt whenever either of them changes. Lookups only
+   * read the header and the single requested offset from the sidecar.
+   */
+ public:
+  LineIndex(string data_filename);
+  ~LineIndex();
+
+  // Byte offset of the start of line `line`, or the size of the data file
+  // if it has fewer lines than that.
+  long LineOffset(int line);
+
+ protected:
+  bool OpenSidecar();
+  void Build();
+  void WriteSidecar();
+
+  string data_filename_;
+  string index_filename_;
+
+  uint64_t file_size_;
+  int64_t mtime_sec_;
+  int64_t mtime_nsec_;
+  uint64_t num_lines_;
+
+  // Exactly one of these is used: the sidecar if it is fresh, otherwise
+  // the offsets that were just built (and written out for next time).
+  FILE *index_file_;
+  vector<uint64_t> offsets_;
+};
+
+#endif
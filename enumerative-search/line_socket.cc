@@ -0,0 +1,150 @@
+#include "line_socket.h"
+#include "utils.h"
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+LineSocket::LineSocket(int fd) :
+  fd_(fd)
+{}
+
+
+// Sends small writes at once. A worker answers a task with several short
+// lines, which Nagle's algorithm would otherwise hold back until the
+// coordinator's delayed ACK, some 40 ms per task. Fails harmlessly on Unix
+// domain sockets.
+static void SetNoDelay(int fd) {
+  int yes = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+}
+
+
+LineSocket::~LineSocket() {
+  close(fd_);
+}
+
+
+LineSocket *LineSocket::Connect(string address) {
+  size_t colon = address.rfind(':');
+  if (colon == string::npos)  return NULL;
+  string host = address.substr(0, colon);
+  string port = address.substr(colon + 1);
+
+  struct addrinfo hints, *addresses;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0)  return NULL;
+
+  int fd = -1;
+  for (auto a = addresses; a != NULL && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  if (fd < 0)  return NULL;
+  SetNoDelay(fd);
+  return new LineSocket(fd);
+}
+
+
+int LineSocket::Listen(int port) {
+  int fd = socket(AF_INET6, SOCK_STREAM, 0);
+  CHECK(fd >= 0, "Could not create a socket");
+  int yes = 1, no = 0;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &no, sizeof(no));
+
+  struct sockaddr_in6 address;
+  memset(&address, 0, sizeof(address));
+  address.sin6_family = AF_INET6;
+  address.sin6_addr = in6addr_any;
+  address.sin6_port = htons(port);
+  CHECK(bind(fd, (struct sockaddr *) &address, sizeof(address)) == 0,
+        "Could not bind to port " << port);
+  CHECK(listen(fd, 64) == 0, "Could not listen on port " << port);
+  return fd;
+}
+
+
+int LineSocket::ListenUnix(string path) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  CHECK(path.size() < sizeof(address.sun_path), "Socket path too long: " << path);
+  strcpy(address.sun_path, path.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  CHECK(fd >= 0, "Could not create a socket");
+  unlink(path.c_str());
+  CHECK(bind(fd, (struct sockaddr *) &address, sizeof(address)) == 0,
+        "Could not bind to " << path);
+  CHECK(listen(fd, 64) == 0, "Could not listen on " << path);
+  return fd;
+}
+
+
+LineSocket *LineSocket::Accept(int listen_fd) {
+  int fd = accept(listen_fd, NULL, NULL);
+  if (fd < 0)  return NULL;
+  SetNoDelay(fd);
+  return new LineSocket(fd);
+}
+
+
+int LineSocket::Fd() const {
+  return fd_;
+}
+
+
+bool LineSocket::Receive() {
+  char data[4096];
+  ssize_t n = read(fd_, data, sizeof(data));
+  if (n <= 0)  return false;
+  buffer_.append(data, n);
+  return true;
+}
+
+
+bool LineSocket::NextLine(string &line) {
+  size_t newline = buffer_.find('\n');
+  if (newline == string::npos)  return false;
+  line = buffer_.substr(0, newline);
+  buffer_.erase(0, newline + 1);
+  return true;
+}
+
+
+bool LineSocket::ReadLine(string &line) {
+  while (!NextLine(line)) {
+    if (!Receive())  return false;
+  }
+  return true;
+}
+
+
+bool LineSocket::Poll(int timeout_ms) {
+  struct pollfd p = {fd_, POLLIN, 0};
+  return poll(&p, 1, timeout_ms) > 0;
+}
+
+
+bool LineSocket::WriteLine(const string &line) {
+  string data = line + "\n";
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = send(fd_, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+    if (n <= 0)  return false;
+    written += n;
+  }
+  return true;
+}
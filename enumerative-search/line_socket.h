@@ -0,0 +1,51 @@
+#ifndef _LINE_SOCKET__
+#define _LINE_SOCKET__
+
+#include <string>
+
+using namespace std;
+
+class LineSocket {
+  /*
+   * LineSocket exchanges newline-terminated text messages over a TCP or
+   * Unix domain socket connection. Reads are buffered, so that a caller
+   * polling several sockets can Receive() whatever arrived and then take
+   * the complete lines one by one with NextLine().
+   */
+ public:
+  // Takes ownership of a connected socket.
+  LineSocket(int fd);
+  ~LineSocket();
+
+  // Connects to HOST:PORT. Returns NULL if that fails.
+  static LineSocket *Connect(string address);
+  // Opens a socket listening on all interfaces. CHECKs that it succeeds.
+  static int Listen(int port);
+  // Opens a Unix domain socket listening at path, replacing any file there.
+  // CHECKs that it succeeds.
+  static int ListenUnix(string path);
+  // Accepts a connection on a listening socket, or returns NULL.
+  static LineSocket *Accept(int listen_fd);
+
+  int Fd() const;
+
+  // Reads the data available on the socket into the buffer, blocking until
+  // there is some. Returns false once the connection is closed.
+  bool Receive();
+  // Takes the next complete line out of the buffer, without the newline.
+  bool NextLine(string &line);
+  // Blocks until a complete line arrived. Returns false if the connection
+  // closes first.
+  bool ReadLine(string &line);
+  // Whether data can be read within timeout_ms milliseconds.
+  bool Poll(int timeout_ms);
+
+  // Returns false if the connection is closed.
+  bool WriteLine(const string &line);
+
+ protected:
+  int fd_;
+  string buffer_;
+};
+
+#endif
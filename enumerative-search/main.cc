@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <ctime>
 #include <fstream>
 #include <ctime>
@@ -5,6 +6,7 @@
 #include <iomanip>
 
 #include <iostream>
+#include <signal.h>
 #include <sstream>
 #include <time.h>
 #include <sys/types.h>
@@ -14,11 +16,25 @@
 #include <stack>
 
 #include "utils.h"
+#include "backward_subgoals.h"
 #include "datum.h"
+#include "depth_first_search.h"
 #include "program_state.h"
 #include "ops.h"
 #include "io_set.h"
 #include "successor.h"
+#include "ranked_op_table.h"
+#include "predictions_matrix.h"
+#include "program_library.h"
+#include "search_budget.h"
+#include "search_cache.h"
+#include "search_checkpoint.h"
+#include "search_coordinator.h"
+#include "search_options.h"
+#include "search_stats.h"
+#include "solution_set.h"
+#include "solver_server.h"
+#include "search_worker.h"
 
 
 using namespace std;
@@ -29,35 +45,50 @@ using namespace std;
 #endif
 
 
-void ApplySuccessor(IOSet *io, const Successor *successor) {
-  if (successor->IsOp1()) {
-    io->ApplyOp1(successor->GetOp1(), successor->GetOp1Arg());
-  } else if (successor->IsOp2()) {
-    io->ApplyOp2(successor->GetOp2(), successor->GetOp2Arg1(),
-                 successor->GetOp2Arg2());
-  }
+// Set by SIGTERM and SIGINT in searches with a checkpoint, which then stop
+// as if their budget ran out and save it.
+static volatile sig_atomic_t stop_requested = 0;
+
+static void RequestStop(int signal) {
+  stop_requested = 1;
 }
 
+
 pair<bool, pair<int, double> > run(string test_set,
                                    int problem_idx,
                                    int num_examples_per_program,
                                    int max_program_length,
                                    int ordering_type,
-                                   int sort_and_add_cutoff) {
+                                   int sort_and_add_cutoff,
+                                   const SearchOptions &options) {
 
-  string order_filename;
+  // The ranked op table is shared by all iterators. Per-problem predictions
+  // are ranked for this run only; dataset-wide orderings are ranked once per
+  // process. With ordering type 1, a consolidated predictions matrix takes
+  // precedence over the per-problem prediction files.
+  const RankedOpTable *table;
+  RankedOpTable *problem_table = NULL;
   if (ordering_type == 0) {
-    order_filename = "data/" + test_set + "/prior.txt";
+    table = RankedOpTable::Shared("data/" + test_set + "/prior.txt", sort_and_add_cutoff);
   } else if (ordering_type == 1) {
-    order_filename = "data/" + test_set + "/predictions/" + to_string(problem_idx) + ".txt";
+    string predictions_filename = "data/" + test_set + "/predictions.bin";
+    if (access(predictions_filename.c_str(), R_OK) == 0) {
+      PredictionsMatrix predictions(predictions_filename);
+      problem_table = new RankedOpTable(predictions, problem_idx, sort_and_add_cutoff);
+    } else {
+      problem_table = new RankedOpTable("data/" + test_set + "/predictions/" +
+                                        to_string(problem_idx) + ".txt", sort_and_add_cutoff);
+    }
+    table = problem_table;
   } else {
-    order_filename = "data/" + test_set + "/random_ordering_" + to_string(-ordering_type) + ".txt";
+    table = RankedOpTable::Shared("data/" + test_set + "/random_ordering_" +
+                                  to_string(-ordering_type) + ".txt", sort_and_add_cutoff);
   }
 
   IOSet *io = new IOSet("data/" + test_set + "/", problem_idx, num_examples_per_program);
 
 #if VERBOSE_MODE  
-  for (int example_idx = 0; example_idx < num_examples_per_program; ++example_idx) {
+  for (int example_idx = 0; example_idx < io->Size(); ++example_idx) {
     ProgramState *ps = io->GetInputs(example_idx);
     Datum *target_datum = io->GetOutput(example_idx);
     cout << "Initial state " << example_idx << ":" << endl << *ps;
@@ -66,76 +97,191 @@ pair<bool, pair<int, double> > run(string test_set,
   cout << endl;
 #endif
 
+  // The config of the search, without the problem's examples.
+  string config = "max_program_length " + to_string(max_program_length) + "\nops";
+  for (auto &successor : table->Successors())  config += " " + successor.Name();
+  config += "\n" + options.Describe();
+  // Coordinator and workers, and checkpoints, also check that they are of
+  // the same problem.
+  string problem_config = "test_set " + test_set + " problem " + to_string(problem_idx) +
+    " examples " + to_string(num_examples_per_program) + "; " + config;
+  replace(problem_config.begin(), problem_config.end(), '\n', ';');
+  if (options.coordinator_port > 0 || !options.worker_address.empty()) {
+    CHECK(options.top_k <= 1, "Distributed search finds a single solution");
+    CHECK(options.checkpoint_filename.empty(), "Distributed search cannot be checkpointed");
+  }
+
+  // A cached result for the same examples and config replaces the search.
+  SearchCache *cache = NULL;
+  if (!options.cache_dir.empty() && options.worker_address.empty()) {
+    cache = new SearchCache(options.cache_dir, io, config);
+
+    MyTimer timer;
+    timer.tic();
+    CachedResult cached;
+    if (cache->Lookup(&cached)) {
+      double secs_taken = timer.toc();
+      cout << "Cache hit: " << cache->Filename() << endl;
+      for (int i = 0; i < cached.solutions.size(); i++) {
+        cout << "Solution " << i + 1 << ":" << endl << cached.solutions[i];
+      }
+      cout << (cached.solved ? "Solved!" : "Failed!") << endl;
+      if (options.top_k > 1) {
+        cout << "Solutions found: " << cached.solutions.size() << endl;
+      }
+      cout << "Nodes explored: " << cached.nodes_explored << endl;
+      cout << secs_taken << endl;
+
+      delete cache;
+      delete io;
+      delete problem_table;
+      return make_pair(cached.solved, make_pair((int) cached.nodes_explored, secs_taken));
+    }
+  }
+
   // Do search
-  int num_nodes_explored = 0;
+  long num_nodes_explored = 0;
   bool succeeded = false;
 
+  INSTRUMENT(SearchStats stats(table, max_program_length));
+
+  int num_inputs = io->GetInputs(0)->NumUsed();
+  SearchBudget budget(options);
+  budget.Start();
+
+  IOSet *heldout = NULL;
+  if (!options.heldout_test_set.empty()) {
+    heldout = new IOSet("data/" + options.heldout_test_set + "/", problem_idx,
+                        options.heldout_examples);
+    CHECK_EQ(heldout->GetInputs(0)->NumUsed(), num_inputs,
+             "held-out inputs do not match the problem's inputs");
+  }
+
+  SolutionSet solutions(max(options.top_k, 1), heldout);
+  vector<string> solution_programs;
+
   MyTimer timer;
   timer.tic();
 
-  vector<SuccessorIterator *> iterators;
-  for (int i = 0; i < max_program_length; i++) {
-    iterators.push_back(new SuccessorIterator(order_filename, io, sort_and_add_cutoff));
+  // Programs from the library are checked first. A hit skips the search.
+  if (!options.library_filename.empty() && options.top_k <= 1 && options.worker_address.empty()) {
+    ProgramLibrary library(options.library_filename);
+    vector<Successor> program;
+    int num_checked = 0;
+    if (library.Find(io, table, max_program_length, program, num_checked)) {
+      vector<const Successor *> statements;
+      for (auto &successor : program)  statements.push_back(&successor);
+      solution_programs.push_back(FormatProgram(statements, program.size(), num_inputs));
+      succeeded = true;
+    }
+    num_nodes_explored += num_checked;
+    cout << "Library " << (succeeded ? "hit" : "miss") << " after checking "
+         << num_checked << " programs" << endl;
   }
 
+  // In bidirectional mode, a first pass searches up to B statements less
+  // deep and stops at the first register that matches a backward subgoal.
+  // The full search only runs if that pass finds nothing.
+  BackwardSubgoals *subgoals = NULL;
+  vector<int> search_lengths;
+  if (options.bidirectional > 0 && options.top_k <= 1 && !succeeded) {
+    subgoals = new BackwardSubgoals(table, io, options.bidirectional);
+    search_lengths.push_back(max(max_program_length - options.bidirectional, 1));
 
-#if VERBOSE_MODE
-  int num_inputs = io->GetInputs(0)->NumUsed();
-  vector<string> fun_name;
-  vector<bool> fun_isUnary;
-  vector<int> fun_operand1, fun_operand2;
-#endif
+    for (int reg = 0; reg < num_inputs && !succeeded && options.worker_address.empty(); reg++) {
+      int match = subgoals->Match(io, reg, max_program_length);
+      if (match >= 0) {
+        vector<Successor> completion = subgoals->Completion(match, reg, num_inputs);
+        CHECK(Solves(io, completion), "Backward subgoal completion does not solve the problem");
+        vector<const Successor *> program;
+        for (auto &statement : completion)  program.push_back(&statement);
+        solution_programs.push_back(FormatProgram(program, program.size(), num_inputs));
+        succeeded = true;
+      }
+    }
+  }
+  search_lengths.push_back(max_program_length);
 
-  int depth = 0;
-  while (depth >=  0) {
-    const Successor *successor = iterators[depth]->Next();
+  DepthFirstSearch *dfs = new DepthFirstSearch(table, io, max_program_length, options, &budget,
+                                               &solutions, subgoals);
+  INSTRUMENT(dfs->SetStats(&stats));
+  if (options.top_k > 1)  dfs->SetSolutionLog(&cout);
 
-    if (successor != NULL) {
-      ApplySuccessor(io, successor);
-      num_nodes_explored++;
+  // Workers only search the tasks of a coordinator.
+  if (!options.worker_address.empty()) {
+    SearchWorker worker(options.worker_address, problem_config);
+    worker.Run(dfs, &budget, search_lengths, subgoals != NULL);
+    double secs_taken = timer.toc();
+    cout << "Tasks searched: " << worker.NumTasks() << endl;
+    cout << "Nodes explored: " << dfs->NumNodesExplored() << endl;
+    cout << secs_taken << endl;
 
-#if VERBOSE_MODE
-      fun_name.push_back(successor->Name());
-      if (successor->IsOp1()) {
-        fun_isUnary.push_back(true);
-        fun_operand1.push_back(successor->GetOp1Arg());
-        fun_operand2.push_back(-1);
-      } else {
-        fun_isUnary.push_back(false);
-        fun_operand1.push_back(successor->GetOp2Arg1());
-        fun_operand2.push_back(successor->GetOp2Arg2());
-      }
-#endif
+    bool solved = dfs->Solved();
+    num_nodes_explored = dfs->NumNodesExplored();
+    delete dfs;
+    delete subgoals;
+    delete heldout;
+    delete io;
+    delete problem_table;
+    return make_pair(solved, make_pair((int) num_nodes_explored, secs_taken));
+  }
 
-      if (io->IsSolved()) {
-        succeeded = true;
-        break;
-      }
+  // A coordinator lists the prefixes of each pass itself, searching the
+  // nodes above them, and has the workers search below them.
+  SearchCoordinator *coordinator = NULL;
+  if (options.coordinator_port > 0 && !succeeded) {
+    coordinator = new SearchCoordinator(options.coordinator_port, problem_config, &budget);
+  }
 
-      if (depth < max_program_length - 1) {
-        depth += 1;
-        iterators[depth]->Init(io);
-      } else {
-        io->Pop();
-#if VERBOSE_MODE
-        fun_name.pop_back();
-        fun_isUnary.pop_back();
-        fun_operand1.pop_back();
-        fun_operand2.pop_back();
-#endif
-      }
+  SearchCheckpoint *checkpoint = NULL;
+  int first_pass = 0;
+  bool resumed = false;
+  if (!options.checkpoint_filename.empty() && !succeeded) {
+    checkpoint = new SearchCheckpoint(options.checkpoint_filename, options.checkpoint_secs,
+                                      problem_config);
+    if (options.resume && checkpoint->Load(table)) {
+      first_pass = checkpoint->pass;
+      resumed = true;
+      cout << "Resuming from " << checkpoint->Filename() << " after "
+           << checkpoint->num_nodes_explored << " nodes" << endl;
+    }
+    dfs->SetCheckpoint(checkpoint);
+    signal(SIGTERM, RequestStop);
+    signal(SIGINT, RequestStop);
+    budget.SetCancelCheck([]() { return stop_requested != 0; });
+  }
+
+  string stop_reason;
+  for (int pass = first_pass; pass < search_lengths.size() && !succeeded && stop_reason.empty(); pass++) {
+    bool use_subgoals = subgoals != NULL && pass == 0;
+    if (checkpoint != NULL)  checkpoint->pass = pass;
+    if (resumed && pass == first_pass) {
+      dfs->Resume(search_lengths[pass], *checkpoint, use_subgoals);
+      succeeded = dfs->Solved();
+      stop_reason = budget.Reason();
+    } else if (coordinator != NULL) {
+      vector<vector<int> > tasks;
+      dfs->Partition(search_lengths[pass], options.prefix_length, use_subgoals, tasks);
+      if (!dfs->Solved() && budget.Reason().empty())  coordinator->Run(pass, tasks);
+      succeeded = dfs->Solved() || coordinator->Solved();
+      stop_reason = budget.Reason().empty() ? coordinator->Reason() : budget.Reason();
     } else {
-      depth -= 1;
-      io->Pop();
-#if VERBOSE_MODE
-      fun_name.pop_back();
-      fun_isUnary.pop_back();
-      fun_operand1.pop_back();
-      fun_operand2.pop_back();
-#endif
+      dfs->Search(search_lengths[pass], vector<int>(), use_subgoals);
+      succeeded = dfs->Solved();
+      stop_reason = budget.Reason();
     }
   }
   double secs_taken = timer.toc();
+  if (resumed)  secs_taken += checkpoint->secs;
+
+  for (auto &program : dfs->SolutionPrograms())  solution_programs.push_back(program);
+  num_nodes_explored += dfs->NumNodesExplored();
+  long num_nodes_pruned = dfs->NumNodesPruned();
+  if (coordinator != NULL) {
+    for (auto &program : coordinator->SolutionPrograms())  solution_programs.push_back(program);
+    num_nodes_explored += coordinator->NumNodesExplored();
+    num_nodes_pruned += coordinator->NumNodesPruned();
+  }
 
   // Print result
   if (succeeded) {
@@ -143,46 +289,110 @@ pair<bool, pair<int, double> > run(string test_set,
   } else {
     cout << "Failed!" << endl;
   }
+  if (options.top_k > 1) {
+    cout << "Solutions found: " << solutions.Size() << endl;
+  }
   cout << "Nodes explored: " << num_nodes_explored << endl;
+  if (options.prune_ranges || options.prune_feasibility || options.prune_unused > 0 ||
+      options.prune_undefined) {
+    cout << "Nodes pruned: " << num_nodes_pruned << endl;
+  }
+  if (coordinator != NULL) {
+    cout << "Workers: " << coordinator->NumWorkers() << endl;
+  }
   cout << secs_taken << endl;
+  if (!stop_reason.empty()) {
+    cout << "Budget exhausted: " << stop_reason << endl;
+    if (coordinator == NULL) {
+      cout << "Nodes explored per depth:";
+      for (auto n : dfs->NodesPerDepth())  cout << " " << n;
+      cout << endl;
+      cout << "Deepest prefix reached:" << endl << dfs->DeepestPrefix();
+      cout << "Prefix at stop:" << endl << dfs->StopPrefix();
+    }
+  }
+  // A search that ran to the end has nothing left to resume.
+  if (checkpoint != NULL && stop_reason.empty()) {
+    checkpoint->Remove();
+  } else if (checkpoint != NULL) {
+    cout << "Checkpoint saved to " << checkpoint->Filename() << endl;
+  }
+  delete checkpoint;
+  delete coordinator;
+  delete dfs;
   delete io;
+  delete heldout;
+  delete subgoals;
+
+  // Results of searches stopped by their budget depend on the budget and
+  // on the machine, so they are not cached.
+  if (cache != NULL && stop_reason.empty()) {
+    CachedResult result;
+    result.solved = succeeded;
+    result.nodes_explored = num_nodes_explored;
+    result.secs = secs_taken;
+    result.solutions = solution_programs;
+    cache->Store(result);
+  }
+  delete cache;
+
+#ifdef INSTRUMENT_MODE
+  string stats_filename = options.stats_filename;
+  if (stats_filename.empty()) {
+    stats_filename = test_set + "_" + to_string(problem_idx) + "_" +
+      to_string(ordering_type) + ".stats.json";
+  }
+  stats.WriteJson(stats_filename, test_set, problem_idx, ordering_type, succeeded,
+                  num_nodes_explored, secs_taken);
+#endif
 
 #if VERBOSE_MODE
   // Print the solution found
   if (succeeded) {
-    cout << "Solution:" << endl;
-    for (int i = 0; i <= depth; ++i) {
-      cout << " %" << i + num_inputs << " <- " << fun_name[i] << " %" << fun_operand1[i];
-      if (!fun_isUnary[i]) {
-        cout << " %" << fun_operand2[i];
-      }
-      cout << endl;
-    }
+    cout << "Solution:" << endl << solution_programs.back();
   }
 #endif
 
-  // Only delete iterators after having printed the solution
-  for (int i = 0; i < max_program_length; i++) {
-    delete iterators[i];
-  }
-  iterators.clear();
+  delete problem_table;
 
-  return make_pair(succeeded, make_pair(num_nodes_explored, secs_taken));
+  return make_pair(succeeded, make_pair((int) num_nodes_explored, secs_taken));
 }
 
 
 int main(int argc, char *argv[])
 {
-  if (argc != 7) {
+  // In server mode there are no positional arguments.
+  SearchOptions options;
+  bool serve = argc > 1 && string(argv[1]).compare(0, 8, "--serve=") == 0;
+  bool options_ok = true;
+  for (int i = serve ? 1 : 7; i < argc; i++)  options_ok = options_ok && options.Parse(argv[i]);
+
+  if ((argc < 7 && !serve) || !options_ok) {
     cout << "Usage:" << endl;
-    cout << "  search TEST_SET_NAME NUM_EXAMPLES MAX_PROG_LEN PROB_IDX ORDER_TYPE SaA_CUTOFF" << endl;
+    cout << "  search TEST_SET_NAME NUM_EXAMPLES MAX_PROG_LEN PROB_IDX ORDER_TYPE SaA_CUTOFF [OPTIONS]" << endl;
+    cout << "  search --serve=stdin|PATH [OPTIONS]" << endl;
+    cout << "Options:" << endl << SearchOptions::Usage();
     exit(1);
   }
+  if (serve) {
+    // Options given here are the defaults of every request.
+    CHECK(options.max_mem_mb == 0, "--max_mem_mb is not supported with --serve");
+    CHECK(options.stats_filename.empty(), "--stats is not supported with --serve");
+    SolverServer server(options, options.threads);
+    if (options.serve == "stdin") {
+      server.Serve(cin, cout);
+    } else {
+      server.ServeSocket(options.serve);
+    }
+    return 0;
+  }
+
   string test_set = argv[1];
   int num_examples_per_program = atoi(argv[2]);
   int max_program_length = atoi(argv[3]);
   int problem_idx = atoi(argv[4]);
   int ordering_type = atoi(argv[5]); // 1 nn, 0 prior, -1,-2,-3,-4,-5,... random orderings 
   int sort_and_add_cutoff = atoi(argv[6]);
-  run(test_set, problem_idx, num_examples_per_program, max_program_length, ordering_type, sort_and_add_cutoff);
+  run(test_set, problem_idx, num_examples_per_program, max_program_length, ordering_type, sort_and_add_cutoff,
+      options);
 }
@@ -0,0 +1,141 @@
+#include "node_scorer.h"
+#include "datum.h"
+#include "io_set.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include "utils.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+
+// Fraction of the values of target that occur in d.
+static double Overlap(Datum *d, Datum *target) {
+  vector<int> values = d->Type() == Int ? vector<int>(1, d->GetIntValue()) : *d->GetValues();
+  vector<int> wanted = target->Type() == Int ? vector<int>(1, target->GetIntValue()) : *target->GetValues();
+  if (wanted.empty())  return 1.0;
+  int found = 0;
+  for (int v : wanted) {
+    if (find(values.begin(), values.end(), v) != values.end())  found++;
+  }
+  return (double) found / wanted.size();
+}
+
+
+static bool IsSorted(Datum *d) {
+  return d->Type() == Array && is_sorted(d->GetValues()->begin(), d->GetValues()->end());
+}
+
+
+static bool SameLength(Datum *d, Datum *target) {
+  return d->Type() == Array && target->Type() == Array && d->Size() == target->Size();
+}
+
+
+vector<string> LinearScorer::OpFeatureNames() {
+  return {"bias", "target_is_int", "last_is_int", "last_same_length", "last_longer",
+          "last_overlap", "last_sorted", "target_sorted", "last_same_multiset",
+          "num_statements"};
+}
+
+
+vector<string> LinearScorer::RegisterFeatureNames() {
+  return {"bias", "is_last", "recency", "is_input", "same_length", "overlap"};
+}
+
+
+LinearScorer::LinearScorer(string filename, const RankedOpTable *table) :
+  op_weights_(table->NumOps(), vector<double>(OpFeatureNames().size(), 0.0)),
+  register_weights_(RegisterFeatureNames().size(), 0.0)
+{
+  ifstream f;
+  f.open(filename);
+  CHECK(f.is_open(), "Failed to open file " + filename);
+
+  string line;
+  while (getline(f, line)) {
+    stringstream ss(line);
+    string kind;
+    if (!(ss >> kind) || kind[0] == '#')  continue;
+
+    vector<double> *weights;
+    if (kind == "op") {
+      string name;
+      ss >> name;
+      int id = table->OpId(name);
+      CHECK(id >= 0, "Unknown op " + name + " in " + filename);
+      weights = &op_weights_[id];
+    } else {
+      CHECK_EQ(kind, "register", "Unexpected line in " + filename + ": " + line);
+      weights = &register_weights_;
+    }
+
+    for (auto &w : *weights)  ss >> w;
+    CHECK(!ss.fail(), "Too few weights in " + filename + ": " + line);
+  }
+}
+
+
+void LinearScorer::OpFeatures(IOSet *io, vector<double> &features) const {
+  features.assign(OpFeatureNames().size(), 0.0);
+  for (int i = 0; i < io->Size(); i++) {
+    ProgramState *ps = io->GetInputs(i);
+    Datum *last = ps->GetLastDatum();
+    Datum *target = io->GetOutput(i);
+    bool same_length = SameLength(last, target);
+
+    features[1] += target->Type() == Int;
+    features[2] += last->Type() == Int;
+    features[3] += same_length;
+    features[4] += last->Type() == Array && target->Type() == Array && last->Size() > target->Size();
+    features[5] += Overlap(last, target);
+    features[6] += IsSorted(last);
+    features[7] += IsSorted(target);
+    if (same_length) {
+      vector<int> a = *last->GetValues(), b = *target->GetValues();
+      sort(a.begin(), a.end());
+      sort(b.begin(), b.end());
+      features[8] += a == b;
+    }
+  }
+  for (auto &x : features)  x /= io->Size();
+  features[0] = 1.0;
+  features[9] = io->GetInputs(0)->NumUsed() - io->GetInputs(0)->NumInputs();
+}
+
+
+void LinearScorer::RegisterFeatures(IOSet *io, int reg, vector<double> &features) const {
+  features.assign(RegisterFeatureNames().size(), 0.0);
+  ProgramState *ps0 = io->GetInputs(0);
+  int last = ps0->NumUsed() - 1;
+  features[0] = 1.0;
+  features[1] = reg == last;
+  features[2] = 1.0 / (1 + last - reg);
+  features[3] = reg < ps0->NumInputs();
+  for (int i = 0; i < io->Size(); i++) {
+    Datum *d = io->GetInputs(i)->GetDatum(reg);
+    features[4] += SameLength(d, io->GetOutput(i)) / (double) io->Size();
+    features[5] += Overlap(d, io->GetOutput(i)) / io->Size();
+  }
+}
+
+
+static double Dot(const vector<double> &a, const vector<double> &b) {
+  double result = 0;
+  for (int i = 0; i < a.size(); i++)  result += a[i] * b[i];
+  return result;
+}
+
+
+void LinearScorer::Score(IOSet *io, vector<double> &op_scores, vector<double> &register_scores) {
+  OpFeatures(io, features_);
+  op_scores.resize(op_weights_.size());
+  for (int id = 0; id < op_weights_.size(); id++)  op_scores[id] = Dot(op_weights_[id], features_);
+
+  int num_registers = io->GetInputs(0)->NumUsed();
+  register_scores.resize(num_registers);
+  for (int reg = 0; reg < num_registers; reg++) {
+    RegisterFeatures(io, reg, features_);
+    register_scores[reg] = Dot(register_weights_, features_);
+  }
+}
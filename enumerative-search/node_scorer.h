@@ -0,0 +1,58 @@
+#ifndef _NODE_SCORER__
+#define _NODE_SCORER__
+
+#include <string>
+#include <vector>
+
+#include "definitions.h"
+
+class IOSet;
+class RankedOpTable;
+
+using namespace std;
+
+class NodeScorer {
+  /*
+   * NodeScorer orders the successors of a search node by the values of its
+   * registers. SuccessorIterator::Init calls Score for every node it is
+   * initialized at, and tries ops by decreasing score and, for every op,
+   * argument registers by decreasing score. Ties keep the ranked order.
+   */
+ public:
+  virtual ~NodeScorer() {}
+
+  // Fills op_scores, indexed by Successor::Id(), and register_scores,
+  // indexed by register. Leaving register_scores empty keeps the register
+  // order.
+  virtual void Score(IOSet *io, vector<double> &op_scores, vector<double> &register_scores) = 0;
+};
+
+
+class LinearScorer : public NodeScorer {
+  /*
+   * LinearScorer scores ops and registers with linear models over a few
+   * features of the registers and targets, averaged over the examples (see
+   * OpFeatureNames and RegisterFeatureNames). The model file has one line
+   * per op, "op NAME w_0 w_1 ...", with a weight per op feature, and one
+   * line "register w_0 w_1 ..." with a weight per register feature. Ops
+   * that are not listed score 0. Lines starting with # are comments.
+   */
+ public:
+  LinearScorer(string filename, const RankedOpTable *table);
+
+  void Score(IOSet *io, vector<double> &op_scores, vector<double> &register_scores);
+
+  static vector<string> OpFeatureNames();
+  static vector<string> RegisterFeatureNames();
+
+ protected:
+  void OpFeatures(IOSet *io, vector<double> &features) const;
+  void RegisterFeatures(IOSet *io, int reg, vector<double> &features) const;
+
+  vector<vector<double> > op_weights_;
+  vector<double> register_weights_;
+
+  vector<double> features_;
+};
+
+#endif
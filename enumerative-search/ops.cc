@@ -139,6 +139,7 @@ void arr_max(Datum *arg1, Datum *result_space) {
     max_val = (cur_val > max_val) ? cur_val : max_val;
   }
   result_space->SetIntValue(max_val);
+  if (arg1->Size() == 0)  result_space->SetDefined(false);
 }
 
 void arr_min(Datum *arg1, Datum *result_space) {
@@ -149,12 +150,14 @@ void arr_min(Datum *arg1, Datum *result_space) {
     min_val = (cur_val < min_val) ? cur_val : min_val;
   }
   result_space->SetIntValue(min_val);
+  if (arg1->Size() == 0)  result_space->SetDefined(false);
 }
 
 void arr_head(Datum *arg1, Datum *result_space) {
   result_space->SetType(Int);
   if (arg1->Size() == 0) {
     result_space->SetIntValue(0);
+    result_space->SetDefined(false);
   } else {
     result_space->SetIntValue(arg1->GetArrayElementValue(0));
   }
@@ -164,6 +167,7 @@ void arr_last(Datum *arg1, Datum *result_space) {
   result_space->SetType(Int);
   if (arg1->Size() == 0) {
     result_space->SetIntValue(0);
+    result_space->SetDefined(false);
   } else {
     int last_idx = arg1->Size() - 1;
     result_space->SetIntValue(arg1->GetArrayElementValue(last_idx));
@@ -315,7 +319,8 @@ void access(Datum *arg1, Datum *arg2, Datum *result_space) {
   if (offset >= 0 && offset < arg2->Size()) {
     result_space->SetIntValue(arg2->GetArrayElementValue(offset));
   } else {
-    result_space->SetIntValue(-1000000);  // TODO: what should happen here?
+    result_space->SetIntValue(-1000000);
+    result_space->SetDefined(false);
   }
 }
 
@@ -336,6 +341,8 @@ void take(Datum *arg1, Datum *arg2, Datum *result_space) {
     int src_val = arg2->GetArrayElementValue(i);
     result_values->push_back(src_val);
   }
+  // A negative count takes from the end in generate_io_samples.py.
+  if (arg1->GetIntValue() < 0)  result_space->SetDefined(false);
 }
 
 void drop(Datum *arg1, Datum *arg2, Datum *result_space) {
@@ -349,6 +356,8 @@ void drop(Datum *arg1, Datum *arg2, Datum *result_space) {
       int src_val = arg2->GetArrayElementValue(i);
       result_values->push_back(src_val);
     }
+  } else {
+    result_space->SetDefined(false);
   }
 }
 
@@ -0,0 +1,107 @@
+#include "predictions_matrix.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static const string kPredictionsMagic = "DCPRED1";
+static const int kPredictionsAlignment = 16;
+
+
+PredictionsMatrix::PredictionsMatrix(string filename, bool use_mmap) :
+  filename_(filename), num_problems_(0), map_(NULL), map_size_(0), data_(NULL)
+{
+  ifstream f;
+  f.open(filename);
+  CHECK(f.is_open(), "Failed to open file " + filename);
+
+  string line;
+  getline(f, line);
+  stringstream ss;
+  ss << line;
+  string magic;
+  int num_components = 0;
+  ss >> magic >> num_problems_ >> num_components;
+  CHECK_EQ(magic, kPredictionsMagic, "Not a predictions matrix: " + filename);
+
+  getline(f, line);
+  stringstream names;
+  names << line;
+  string name;
+  while (names >> name)  components_.push_back(name);
+  CHECK_EQ(components_.size(), num_components, "Inconsistent predictions header in " + filename);
+
+  long header_size = f.tellg();
+  f.close();
+  CHECK_EQ(header_size % kPredictionsAlignment, 0, "Unaligned predictions header in " + filename);
+
+  struct stat st;
+  CHECK(stat(filename.c_str(), &st) == 0, "Failed to stat file " + filename);
+  size_t matrix_size = (size_t) num_problems_ * num_components * sizeof(float);
+  CHECK_EQ(st.st_size, header_size + matrix_size, "Truncated predictions matrix " + filename);
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  CHECK(fd >= 0, "Failed to open file " + filename);
+  if (use_mmap) {
+    map_size_ = st.st_size;
+    map_ = mmap(NULL, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    CHECK(map_ != MAP_FAILED, "Failed to mmap " + filename);
+    data_ = (const float *) ((const char *) map_ + header_size);
+  } else {
+    values_.resize((size_t) num_problems_ * num_components);
+    CHECK_EQ(pread(fd, values_.data(), matrix_size, header_size), (ssize_t) matrix_size,
+             "Failed to read " + filename);
+    data_ = values_.data();
+  }
+  close(fd);
+}
+
+
+PredictionsMatrix::~PredictionsMatrix() {
+  if (map_ != NULL)  munmap(map_, map_size_);
+}
+
+
+int PredictionsMatrix::NumProblems() const {
+  return num_problems_;
+}
+
+
+int PredictionsMatrix::NumComponents() const {
+  return components_.size();
+}
+
+
+string PredictionsMatrix::ComponentName(int i) const {
+  return components_[i];
+}
+
+
+const float *PredictionsMatrix::Row(int problem_idx) const {
+  CHECK_LT(problem_idx, num_problems_, "Problem index out of bounds in " + filename_);
+  return data_ + (size_t) problem_idx * components_.size();
+}
+
+
+void PredictionsMatrix::Write(string filename, const vector<string> &components,
+                              const vector<vector<float> > &rows) {
+  string header = kPredictionsMagic + " " + to_string(rows.size()) + " " +
+    to_string(components.size()) + "\n";
+  for (auto &name : components)  header += name + " ";
+  while ((header.size() + 1) % kPredictionsAlignment != 0)  header += " ";
+  header += "\n";
+
+  ofstream f;
+  f.open(filename, ios::binary);
+  CHECK(f.is_open(), "Failed to open file " + filename);
+  f.write(header.data(), header.size());
+  for (auto &row : rows) {
+    CHECK_EQ(row.size(), components.size(), "Predictions row has wrong number of components");
+    f.write((const char *) row.data(), row.size() * sizeof(float));
+  }
+  CHECK(f.good(), "Failed to write " + filename);
+}
@@ -0,0 +1,48 @@
+#ifndef _PREDICTIONS_MATRIX__
+#define _PREDICTIONS_MATRIX__
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class PredictionsMatrix {
+  /*
+   * PredictionsMatrix holds the per-problem DSL component probabilities of
+   * a whole dataset in one file, as a dense float32 matrix with one row per
+   * problem. The column order is fixed by the component names in the
+   * header. The layout is:
+   *
+   *   DCPRED1 NUM_PROBLEMS NUM_COMPONENTS\n
+   *   NAME_0 NAME_1 ... NAME_{NUM_COMPONENTS-1}   (space padded)\n
+   *   float32[NUM_PROBLEMS][NUM_COMPONENTS]
+   *
+   * The second line is padded so that the matrix starts 16-byte aligned,
+   * which lets it be mmapped and read in place.
+   */
+ public:
+  PredictionsMatrix(string filename, bool use_mmap = true);
+  ~PredictionsMatrix();
+
+  int NumProblems() const;
+  int NumComponents() const;
+  string ComponentName(int i) const;
+  const float *Row(int problem_idx) const;
+
+  static void Write(string filename, const vector<string> &components,
+                    const vector<vector<float> > &rows);
+
+ protected:
+  string filename_;
+  int num_problems_;
+  vector<string> components_;
+
+  // Mapped file (if use_mmap) or a heap copy of the matrix (otherwise).
+  void *map_;
+  size_t map_size_;
+  vector<float> values_;
+  const float *data_;
+};
+
+#endif
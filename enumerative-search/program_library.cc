@@ -0,0 +1,154 @@
+#include "program_library.h"
+#include "io_set.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include "successor.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static const string kLibraryMagic = "DCLIB2";
+static const int kLibraryAlignment = 16;
+
+
+ProgramLibrary::ProgramLibrary(string filename) :
+  filename_(filename), map_(NULL), map_size_(0), programs_(NULL)
+{
+  ifstream f;
+  f.open(filename);
+  CHECK(f.is_open(), "Failed to open file " + filename);
+
+  string line, magic;
+  size_t num_signatures = 0, num_programs = 0;
+  getline(f, line);
+  stringstream header(line);
+  header >> magic >> num_signatures >> num_programs;
+  CHECK_EQ(magic, kLibraryMagic, "Not a program library: " + filename);
+
+  RankedOpTable ops;
+  getline(f, line);
+  stringstream names(line);
+  string name;
+  int num_ops = 0;
+  while (names >> name) {
+    CHECK(num_ops < ops.NumOps() && ops.Op(num_ops).Name() == name,
+          "Program library " + filename + " was built for different ops; rebuild it");
+    num_ops++;
+  }
+  CHECK_EQ(num_ops, ops.NumOps(), "Program library " + filename + " was built for different ops; rebuild it");
+
+  getline(f, line);
+  stringstream index(line);
+  for (size_t i = 0; i < num_signatures; i++) {
+    string signature;
+    size_t first, count;
+    index >> signature >> first >> count;
+    CHECK(!index.fail() && first + count <= num_programs, "Corrupt program library index in " + filename);
+    signatures_.push_back(signature);
+    first_.push_back(first);
+    count_.push_back(count);
+  }
+
+  long header_size = f.tellg();
+  f.close();
+  CHECK_EQ(header_size % kLibraryAlignment, 0, "Unaligned program library header in " + filename);
+
+  struct stat st;
+  CHECK(stat(filename.c_str(), &st) == 0, "Failed to stat file " + filename);
+  CHECK_EQ(st.st_size, header_size + num_programs * sizeof(Program), "Truncated program library " + filename);
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  CHECK(fd >= 0, "Failed to open file " + filename);
+  map_size_ = st.st_size;
+  map_ = mmap(NULL, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+  CHECK(map_ != MAP_FAILED, "Failed to mmap " + filename);
+  programs_ = (const Program *) ((const char *) map_ + header_size);
+  close(fd);
+}
+
+
+ProgramLibrary::~ProgramLibrary() {
+  if (map_ != NULL)  munmap(map_, map_size_);
+}
+
+
+string ProgramLibrary::Signature(IOSet *io) {
+  ProgramState *ps = io->GetInputs(0);
+  string result;
+  for (int i = 0; i < ps->NumUsed(); i++) {
+    if (i > 0)  result += ",";
+    result += (ps->GetDatumType(i) == Int) ? "Int" : "Array";
+  }
+  return result;
+}
+
+
+bool ProgramLibrary::Find(IOSet *io, const RankedOpTable *table, int max_length,
+                          vector<Successor> &program, int &num_checked) const {
+  num_checked = 0;
+  int s = find(signatures_.begin(), signatures_.end(), Signature(io)) - signatures_.begin();
+  if (s == signatures_.size())  return false;
+
+  vector<bool> allowed(table->NumOps(), false);
+  for (auto &successor : table->Successors())  allowed[successor.Id()] = true;
+
+  for (size_t i = first_[s]; i < first_[s] + count_[s]; i++) {
+    const Program &p = programs_[i];
+    if (p.length > max_length)  break;
+
+    bool usable = true;
+    for (int j = 0; j < p.length; j++)  usable = usable && allowed[p.steps[j].op_id];
+    if (!usable)  continue;
+
+    program.clear();
+    for (int j = 0; j < p.length; j++) {
+      Successor successor = table->Op(p.steps[j].op_id);
+      if (successor.IsOp1()) {
+        successor.SetOp1Arg(p.steps[j].arg1);
+      } else {
+        successor.SetOp2Args(p.steps[j].arg1, p.steps[j].arg2);
+      }
+      program.push_back(successor);
+    }
+
+    num_checked++;
+    for (auto &successor : program)  ApplySuccessor(io, &successor);
+    bool solved = io->IsSolved();
+    for (int j = 0; j < p.length; j++)  io->Pop();
+    if (solved)  return true;
+  }
+  program.clear();
+  return false;
+}
+
+
+void ProgramLibrary::Write(string filename, const vector<string> &signatures,
+                           const vector<vector<Program> > &programs) {
+  RankedOpTable ops;
+  size_t num_programs = 0;
+  for (auto &p : programs)  num_programs += p.size();
+
+  string header = kLibraryMagic + " " + to_string(signatures.size()) + " " +
+    to_string(num_programs) + "\n";
+  for (int i = 0; i < ops.NumOps(); i++)  header += ops.Op(i).Name() + " ";
+  header += "\n";
+  size_t first = 0;
+  for (int i = 0; i < signatures.size(); i++) {
+    header += signatures[i] + " " + to_string(first) + " " + to_string(programs[i].size()) + " ";
+    first += programs[i].size();
+  }
+  while ((header.size() + 1) % kLibraryAlignment != 0)  header += " ";
+  header += "\n";
+
+  ofstream f;
+  f.open(filename, ios::binary);
+  CHECK(f.is_open(), "Failed to open file " + filename);
+  f.write(header.data(), header.size());
+  for (auto &p : programs)  f.write((const char *) p.data(), p.size() * sizeof(Program));
+  CHECK(f.good(), "Failed to write " + filename);
+}
@@ -0,0 +1,81 @@
+#ifndef _PROGRAM_LIBRARY__
+#define _PROGRAM_LIBRARY__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "definitions.h"
+
+class IOSet;
+class RankedOpTable;
+class Successor;
+
+using namespace std;
+
+class ProgramLibrary {
+  /*
+   * ProgramLibrary holds precomputed lists of candidate programs for a set
+   * of input type signatures (see tools/build_library). For every signature,
+   * all programs up to kMaxLength statements were run on fixed probe inputs,
+   * and only one program (the shortest) was kept per distinct output on the
+   * probes. The probes are not the examples of a problem, so a lookup still
+   * runs the candidates one by one. Programs are stored shortest first, so
+   * the first one consistent with the examples of a problem is also a
+   * shortest one in the library.
+   *
+   * The layout is:
+   *
+   *   DCLIB2 NUM_SIGNATURES NUM_PROGRAMS\n
+   *   OP_NAME_0 OP_NAME_1 ...\n
+   *   SIGNATURE_0 FIRST_0 COUNT_0 SIGNATURE_1 FIRST_1 COUNT_1 ...   (space padded)\n
+   *   Program[NUM_PROGRAMS]
+   *
+   * where a signature is the comma separated list of input types, e.g.
+   * Int,Array. The op names must match RankedOpTable's, so a library built
+   * for another version of the DSL is rejected.
+   */
+ public:
+  static const int kMaxLength = 3;
+
+  struct Step {
+    int16_t op_id;
+    int8_t arg1;
+    int8_t arg2;
+  };
+
+  struct Program {
+    int32_t length;
+    Step steps[kMaxLength];
+  };
+
+  ProgramLibrary(string filename);
+  ~ProgramLibrary();
+
+  // Signature of the inputs of an IOSet, e.g. Int,Array.
+  static string Signature(IOSet *io);
+
+  // Checks the library programs for the signature of io against its
+  // examples, shortest first, skipping programs longer than max_length or
+  // using ops that are not in table's ranked list. Returns true and the
+  // statements of the first consistent program, if any. num_checked counts
+  // the programs run.
+  bool Find(IOSet *io, const RankedOpTable *table, int max_length,
+            /*out*/ vector<Successor> &program, /*out*/ int &num_checked) const;
+
+  static void Write(string filename, const vector<string> &signatures,
+                    const vector<vector<Program> > &programs);
+
+ protected:
+  string filename_;
+  vector<string> signatures_;
+  vector<size_t> first_;
+  vector<size_t> count_;
+
+  void *map_;
+  size_t map_size_;
+  const Program *programs_;
+};
+
+#endif
@@ -0,0 +1,212 @@
+#include "program_parser.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+
+// The ops of ops.cc by their name in the syntax of generate_io_samples.py.
+static const map<string, string> &OpNames() {
+  static const map<string, string> names = {
+    {"HEAD", "arr_head"}, {"LAST", "arr_last"}, {"MINIMUM", "arr_min"}, {"MAXIMUM", "arr_max"},
+    {"SUM", "arr_sum"}, {"REVERSE", "reverse"}, {"SORT", "sort"},
+    {"TAKE", "take"}, {"DROP", "drop"}, {"ACCESS", "access"},
+    {"MAP INC", "map_increment"}, {"MAP DEC", "map_decrement"}, {"MAP SHL", "map_mult2"},
+    {"MAP SHR", "map_div2"}, {"MAP doNEG", "map_negate"}, {"MAP SQR", "map_sqr"},
+    {"MAP MUL3", "map_mult3"}, {"MAP DIV3", "map_div3"}, {"MAP MUL4", "map_mult4"},
+    {"MAP DIV4", "map_div4"},
+    {"FILTER isPOS", "filter_is_pos"}, {"FILTER isNEG", "filter_is_neg"},
+    {"FILTER isODD", "filter_is_odd"}, {"FILTER isEVEN", "filter_is_even"},
+    {"COUNT isPOS", "count_is_pos"}, {"COUNT isNEG", "count_is_neg"},
+    {"COUNT isODD", "count_is_odd"}, {"COUNT isEVEN", "count_is_even"},
+    {"ZIPWITH +", "zipwith_add"}, {"ZIPWITH -", "zipwith_subtract"}, {"ZIPWITH *", "zipwith_mult"},
+    {"ZIPWITH MAX", "zipwith_max"}, {"ZIPWITH MIN", "zipwith_min"},
+    {"SCANL1 +", "scanl_add"}, {"SCANL1 -", "scanl_subtract"}, {"SCANL1 *", "scanl_mult"},
+    {"SCANL1 MAX", "scanl_max"}, {"SCANL1 MIN", "scanl_min"}};
+  return names;
+}
+
+
+string DslName(const string &op_name) {
+  for (auto &entry : OpNames()) {
+    if (entry.second == op_name)  return entry.first;
+  }
+  return "";
+}
+
+
+static string Trim(const string &s) {
+  size_t begin = s.find_first_not_of(" \t\r");
+  if (begin == string::npos)  return "";
+  return s.substr(begin, s.find_last_not_of(" \t\r") - begin + 1);
+}
+
+
+static vector<DatumType> ArgTypes(const Successor &op) {
+  if (op.IsOp1())  return vector<DatumType>({op.GetOp1ArgType()});
+  return vector<DatumType>({op.GetOp2Arg1Type(), op.GetOp2Arg2Type()});
+}
+
+
+// Checks the argument registers of op against the registers so far, and
+// appends the statement to the program.
+static bool AddStatement(const Successor &op, const vector<int> &args, const string &source,
+                         vector<DatumType> &types, ParsedProgram *program, string *error) {
+  vector<DatumType> arg_types = ArgTypes(op);
+  if (args.size() != arg_types.size()) {
+    *error = "wrong number of arguments in \"" + source + "\"";
+    return false;
+  }
+  for (int a = 0; a < args.size(); a++) {
+    if (args[a] < 0 || args[a] >= types.size() || types[args[a]] != arg_types[a]) {
+      *error = "bad argument " + to_string(a + 1) + " in \"" + source + "\"";
+      return false;
+    }
+  }
+
+  Successor statement = op;
+  if (statement.IsOp1()) {
+    statement.SetOp1Arg(args[0]);
+  } else {
+    statement.SetOp2Args(args[0], args[1]);
+  }
+  program->statements.push_back(statement);
+  types.push_back(op.ResultType());
+  return true;
+}
+
+
+static bool ParseDslProgram(const RankedOpTable &table, const string &source,
+                            const vector<DatumType> &input_types, ParsedProgram *program,
+                            string *error) {
+  vector<DatumType> types;
+  stringstream ss(source);
+  string line;
+  while (getline(ss, line, '|')) {
+    line = Trim(line);
+    size_t arrow = line.find("<-");
+    if (arrow == string::npos) {
+      *error = "expected <- in \"" + line + "\"";
+      return false;
+    }
+    string instruction = Trim(line.substr(arrow + 2));
+
+    if (instruction == "int" || instruction == "[int]") {
+      if (!program->statements.empty()) {
+        *error = "inputs must come before the statements";
+        return false;
+      }
+      types.push_back(instruction == "int" ? Int : Array);
+      continue;
+    }
+
+    // A command, possibly followed by a lambda, and single-letter registers.
+    vector<string> words;
+    stringstream words_ss(instruction);
+    string word;
+    while (words_ss >> word)  words.push_back(word);
+    if (words.empty()) {
+      *error = "missing function in \"" + line + "\"";
+      return false;
+    }
+    string command = words[0];
+    int first_arg = 1;
+    if (words.size() > 1 && (words[1].size() > 1 || words[1][0] < 'a' || words[1][0] > 'z')) {
+      command += " " + words[1];
+      first_arg = 2;
+    }
+    auto it = OpNames().find(command);
+    int op_id = it == OpNames().end() ? -1 : table.OpId(it->second);
+    if (op_id < 0) {
+      *error = "unsupported function " + command;
+      return false;
+    }
+
+    vector<int> args;
+    for (int w = first_arg; w < words.size(); w++) {
+      args.push_back(words[w].size() == 1 ? words[w][0] - 'a' : -1);
+    }
+    if (!AddStatement(table.Op(op_id), args, line, types, program, error))  return false;
+  }
+
+  program->input_types.assign(types.begin(), types.begin() + (types.size() - program->statements.size()));
+  if (!input_types.empty() && program->input_types != input_types) {
+    *error = "the inputs do not match the types of the examples";
+    return false;
+  }
+  return true;
+}
+
+
+// Parses "%k" into k, or returns -1.
+static int ParseRegister(const string &word) {
+  if (word.size() < 2 || word[0] != '%')  return -1;
+  char *end;
+  long reg = strtol(word.c_str() + 1, &end, 10);
+  return *end == '\0' ? reg : -1;
+}
+
+
+static bool ParseSearchProgram(const RankedOpTable &table, const string &source,
+                               const vector<DatumType> &input_types, ParsedProgram *program,
+                               string *error) {
+  if (input_types.empty()) {
+    *error = "the types of the inputs are not known";
+    return false;
+  }
+  program->input_types = input_types;
+  vector<DatumType> types = input_types;
+
+  string lines = source;
+  replace(lines.begin(), lines.end(), '\n', '|');
+  stringstream ss(lines);
+  string line;
+  while (getline(ss, line, '|')) {
+    line = Trim(line);
+    if (line.empty())  continue;
+    stringstream words_ss(line);
+    string result, arrow, name, word;
+    words_ss >> result >> arrow >> name;
+    if (ParseRegister(result) != types.size() || arrow != "<-") {
+      *error = "expected %" + to_string(types.size()) + " <- in \"" + line + "\"";
+      return false;
+    }
+    int op_id = table.OpId(name);
+    if (op_id < 0) {
+      *error = "unknown op " + name;
+      return false;
+    }
+    vector<int> args;
+    while (words_ss >> word)  args.push_back(ParseRegister(word));
+    if (!AddStatement(table.Op(op_id), args, line, types, program, error))  return false;
+  }
+  return true;
+}
+
+
+bool ParseProgram(const RankedOpTable &table, const string &source,
+                  const vector<DatumType> &input_types, ParsedProgram *program, string *error) {
+  program->input_types.clear();
+  program->statements.clear();
+  string first = Trim(source);
+  bool ok = !first.empty() && first[0] == '%' ?
+    ParseSearchProgram(table, source, input_types, program, error) :
+    ParseDslProgram(table, source, input_types, program, error);
+  if (ok && (program->input_types.empty() || program->statements.empty())) {
+    *error = "a program needs inputs and statements";
+    return false;
+  }
+  return ok;
+}
+
+
+void RunProgram(const ParsedProgram &program, ProgramState *ps) {
+  for (auto &statement : program.statements) {
+    if (statement.IsOp1()) {
+      ps->ApplyOp1(statement.GetOp1(), statement.GetOp1Arg());
+    } else {
+      ps->ApplyOp2(statement.GetOp2(), statement.GetOp2Arg1(), statement.GetOp2Arg2());
+    }
+  }
+}
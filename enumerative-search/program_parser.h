@@ -0,0 +1,41 @@
+#ifndef _PROGRAM_PARSER__
+#define _PROGRAM_PARSER__
+
+#include <string>
+#include <vector>
+
+#include "definitions.h"
+#include "successor.h"
+
+class ProgramState;
+class RankedOpTable;
+
+using namespace std;
+
+// A program as the ops of a RankedOpTable, with their argument registers
+// set. Registers are numbered as in the search: the inputs first, then one
+// per statement.
+struct ParsedProgram {
+  vector<DatumType> input_types;
+  vector<Successor> statements;
+};
+
+// Parses a program in the syntax of generate_io_samples.py,
+//   a <- [int] | b <- int | c <- TAKE b a
+// or in the output syntax of the search, with statements separated by
+// newlines or |,
+//   %2 <- take %1 %0
+// The search syntax does not declare the inputs, whose types are then taken
+// from input_types; if input_types is not empty, declared inputs must match
+// it. Returns false with the reason in *error.
+bool ParseProgram(const RankedOpTable &table, const string &source,
+                  const vector<DatumType> &input_types, ParsedProgram *program, string *error);
+
+// The name of an op in the syntax of generate_io_samples.py, e.g. "MAP INC"
+// for map_increment, or "" for ops it does not have.
+string DslName(const string &op_name);
+
+// Appends the registers of the statements to ps.
+void RunProgram(const ParsedProgram &program, ProgramState *ps);
+
+#endif
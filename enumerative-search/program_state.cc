@@ -15,6 +15,11 @@ ProgramState::~ProgramState() {
 }
 
 
+int ProgramState::NumInputs() const {
+  return num_inputs_;
+}
+
+
 int ProgramState::NumUsed() const {
   return num_used_;
 }
@@ -58,6 +63,7 @@ void ProgramState::ApplyOp1(DatumOp1 op, int arg1_idx) {
 
   Datum *arg1 = GetDatum(arg1_idx);
 
+  data_[result_idx]->SetDefined(arg1->Defined());
   op(arg1, data_[result_idx]);
   num_used_++;
 }
@@ -69,6 +75,7 @@ void ProgramState::ApplyOp2(DatumOp2 op, int arg1_idx, int arg2_idx) {
   Datum *arg1 = GetDatum(arg1_idx);
   Datum *arg2 = GetDatum(arg2_idx);
 
+  data_[result_idx]->SetDefined(arg1->Defined() && arg2->Defined());
   op(arg1, arg2, data_[result_idx]);
   num_used_++;
 }
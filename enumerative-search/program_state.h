@@ -20,6 +20,7 @@ class ProgramState {
   Datum* GetLastDatum() const;
   DatumType GetDatumType(int i) const;
 
+  int NumInputs() const;
   int NumUsed() const;
   int NumAllocated() const;
   int NumInts() const;
@@ -0,0 +1,311 @@
+#include "range_analysis.h"
+#include "datum.h"
+#include "io_set.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include <algorithm>
+#include <climits>
+
+
+// Value access returns for an out of range index.
+static const int64_t kAccessDefault = -1000000;
+
+
+// Widens intervals that leave the int range, as the ops wrap around.
+static RangeAnalysis::Interval Saturate(RangeAnalysis::Interval x) {
+  if (x.Empty())  return x;
+  if (x.lo < INT_MIN || x.hi > INT_MAX)  return RangeAnalysis::Interval(INT_MIN, INT_MAX);
+  return x;
+}
+
+
+static RangeAnalysis::Interval Hull(int64_t a, int64_t b, int64_t c, int64_t d) {
+  return RangeAnalysis::Interval(min(min(a, b), min(c, d)), max(max(a, b), max(c, d)));
+}
+
+
+RangeAnalysis::Interval::Interval() :
+  lo(1), hi(0)
+{}
+
+
+RangeAnalysis::Interval::Interval(int64_t lo, int64_t hi) :
+  lo(lo), hi(hi)
+{}
+
+
+bool RangeAnalysis::Interval::Empty() const {
+  return lo > hi;
+}
+
+
+bool RangeAnalysis::Interval::Contains(int64_t x) const {
+  return lo <= x && x <= hi;
+}
+
+
+bool RangeAnalysis::Interval::Contains(const Interval &other) const {
+  return other.Empty() || (lo <= other.lo && other.hi <= hi);
+}
+
+
+void RangeAnalysis::Interval::Add(const Interval &other) {
+  if (other.Empty())  return;
+  if (Empty()) {
+    *this = other;
+  } else {
+    lo = min(lo, other.lo);
+    hi = max(hi, other.hi);
+  }
+}
+
+
+void RangeAnalysis::Interval::Add(int64_t x) {
+  Add(Interval(x, x));
+}
+
+
+RangeAnalysis::State::State() :
+  min_length(0), max_length(0), has_array(false)
+{}
+
+
+void RangeAnalysis::State::Add(const State &other) {
+  ints.Add(other.ints);
+  elements.Add(other.elements);
+  if (!other.has_array)  return;
+  if (has_array) {
+    min_length = min(min_length, other.min_length);
+    max_length = max(max_length, other.max_length);
+  } else {
+    min_length = other.min_length;
+    max_length = other.max_length;
+  }
+  has_array = true;
+}
+
+
+RangeAnalysis::RangeAnalysis(const RankedOpTable *table, IOSet *io) {
+  for (auto &successor : table->Successors()) {
+    string name = successor.Name();
+    OpKind kind = kUnknown;
+    int k = 0;
+    if (name == "increment")  kind = kIncrement;
+    else if (name == "decrement")  kind = kDecrement;
+    else if (name == "arr_min")  kind = kMin;
+    else if (name == "arr_max")  kind = kMax;
+    else if (name == "arr_head" || name == "arr_last")  kind = kHeadLast;
+    else if (name == "arr_sum")  kind = kSum;
+    else if (name.compare(0, 6, "count_") == 0)  kind = kCount;
+    else if (name == "map_increment")  kind = kMapAdd, k = 1;
+    else if (name == "map_decrement")  kind = kMapAdd, k = -1;
+    else if (name.compare(0, 8, "map_mult") == 0)  kind = kMapMult, k = atoi(name.c_str() + 8);
+    else if (name.compare(0, 7, "map_div") == 0)  kind = kMapDiv, k = atoi(name.c_str() + 7);
+    else if (name == "map_negate")  kind = kNegate;
+    else if (name == "map_sqr")  kind = kSqr;
+    else if (name == "filter_is_pos")  kind = kFilterPos;
+    else if (name == "filter_is_neg")  kind = kFilterNeg;
+    else if (name == "filter_is_odd" || name == "filter_is_even")  kind = kFilter;
+    else if (name == "sort" || name == "reverse")  kind = kPermute;
+    else if (name == "scanl_add")  kind = kScanAdd;
+    else if (name == "scanl_subtract")  kind = kScanSubtract;
+    else if (name == "scanl_mult")  kind = kScanMult;
+    else if (name == "scanl_max" || name == "scanl_min")  kind = kScanMinMax;
+    else if (name == "access")  kind = kAccess;
+    else if (name == "take" || name == "drop")  kind = kSublist;
+    else if (name == "zipwith_add")  kind = kZipAdd;
+    else if (name == "zipwith_subtract")  kind = kZipSubtract;
+    else if (name == "zipwith_mult")  kind = kZipMult;
+    else if (name == "zipwith_max" || name == "zipwith_min")  kind = kZipMinMax;
+    if ((kind == kMapMult || kind == kMapDiv) && k <= 0)  kind = kUnknown;
+    ops_.push_back(make_pair(kind, k));
+  }
+
+  for (int i = 0; i < io->Size(); i++) {
+    Datum *output = io->GetOutput(i);
+    Target target;
+    target.type = output->Type();
+    target.value = 0;
+    target.length = 0;
+    if (target.type == Int) {
+      target.value = output->GetIntValue();
+    } else {
+      target.length = output->Size();
+      for (int j = 0; j < output->Size(); j++)  target.elements.Add(output->GetArrayElementValue(j));
+    }
+    targets_.push_back(target);
+  }
+}
+
+
+RangeAnalysis::State RangeAnalysis::Summarize(ProgramState *ps) const {
+  State s;
+  for (int i = 0; i < ps->NumUsed(); i++) {
+    Datum *d = ps->GetDatum(i);
+    if (d->Type() == Int) {
+      s.ints.Add(d->GetIntValue());
+    } else {
+      State array;
+      array.has_array = true;
+      array.min_length = array.max_length = d->Size();
+      for (int j = 0; j < d->Size(); j++)  array.elements.Add(d->GetArrayElementValue(j));
+      s.Add(array);
+    }
+  }
+  return s;
+}
+
+
+// One more statement: the union of s and of every ranked op applied to s.
+RangeAnalysis::State RangeAnalysis::Step(const State &s) const {
+  State result = s;
+  const Interval &e = s.elements;
+  int64_t n = s.max_length;
+
+  for (auto &op : ops_) {
+    OpKind kind = op.first;
+    int64_t k = op.second;
+
+    // Ops with an int argument.
+    if (kind == kIncrement || kind == kDecrement) {
+      if (s.ints.Empty())  continue;
+      int64_t delta = (kind == kIncrement) ? 1 : -1;
+      result.ints.Add(Saturate(Interval(s.ints.lo + delta, s.ints.hi + delta)));
+      continue;
+    }
+    if (kind == kUnknown) {
+      result.ints.Add(Interval(INT_MIN, INT_MAX));
+      result.elements.Add(Interval(INT_MIN, INT_MAX));
+      continue;
+    }
+
+    // All other ops take an array.
+    if (!s.has_array)  continue;
+    if ((kind == kAccess || kind == kSublist) && s.ints.Empty())  continue;
+
+    State array;
+    array.has_array = true;
+    array.min_length = s.min_length;
+    array.max_length = n;
+    Interval values;
+
+    switch (kind) {
+    case kMin:
+    case kMax:
+      result.ints.Add(e);
+      if (s.min_length == 0)  result.ints.Add(kind == kMin ? INT_MAX : INT_MIN);
+      continue;
+    case kHeadLast:
+      result.ints.Add(e);
+      if (s.min_length == 0)  result.ints.Add(0);
+      continue;
+    case kSum:
+      if (e.Empty()) {
+        result.ints.Add(0);
+      } else {
+        result.ints.Add(Saturate(Hull(s.min_length * e.lo, n * e.lo,
+                                      s.min_length * e.hi, n * e.hi)));
+      }
+      continue;
+    case kCount:
+      result.ints.Add(Interval(0, n));
+      continue;
+    case kAccess:
+      result.ints.Add(e);
+      result.ints.Add(kAccessDefault);
+      continue;
+
+    case kMapAdd:
+      if (!e.Empty())  values = Saturate(Interval(e.lo + k, e.hi + k));
+      break;
+    case kMapMult:
+      if (!e.Empty())  values = Saturate(Interval(e.lo * k, e.hi * k));
+      break;
+    case kMapDiv:
+      if (!e.Empty())  values = Interval(e.lo / k, e.hi / k);
+      break;
+    case kNegate:
+      if (!e.Empty())  values = Saturate(Interval(-e.hi, -e.lo));
+      break;
+    case kSqr:
+      if (!e.Empty()) {
+        int64_t low = (e.lo <= 0 && e.hi >= 0) ? 0 : min(e.lo * e.lo, e.hi * e.hi);
+        values = Saturate(Interval(low, max(e.lo * e.lo, e.hi * e.hi)));
+      }
+      break;
+    case kFilterPos:
+      values = Interval(max(e.lo, (int64_t) 1), e.hi);
+      array.min_length = 0;
+      break;
+    case kFilterNeg:
+      values = Interval(e.lo, min(e.hi, (int64_t) -1));
+      array.min_length = 0;
+      break;
+    case kFilter:
+    case kSublist:
+      values = e;
+      array.min_length = 0;
+      break;
+    case kPermute:
+    case kScanMinMax:
+    case kZipMinMax:
+      values = e;
+      break;
+    case kScanAdd:
+      // The i-th partial sum lies in [i * lo, i * hi] for 1 <= i <= n.
+      if (!e.Empty())  values = Saturate(Hull(e.lo, n * e.lo, e.hi, n * e.hi));
+      break;
+    case kScanSubtract:
+      // x_0 - x_1 - ... - x_{i-1}
+      if (!e.Empty()) {
+        values = Saturate(Hull(e.lo, e.lo - (n - 1) * e.hi, e.hi, e.hi - (n - 1) * e.lo));
+      }
+      break;
+    case kScanMult:
+      if (!e.Empty()) {
+        // Products of up to n elements are bounded by m^n in absolute value.
+        int64_t m = max(max(-e.lo, e.hi), (int64_t) 1);
+        int64_t bound = m;
+        for (int64_t i = 1; i < n && bound <= INT_MAX; i++)  bound *= m;
+        values = Saturate(Interval(e.lo >= 0 ? min(e.lo, (int64_t) 1) : -bound, bound));
+      }
+      break;
+    case kZipAdd:
+      if (!e.Empty())  values = Saturate(Interval(2 * e.lo, 2 * e.hi));
+      break;
+    case kZipSubtract:
+      if (!e.Empty())  values = Saturate(Interval(e.lo - e.hi, e.hi - e.lo));
+      break;
+    case kZipMult:
+      if (!e.Empty())  values = Saturate(Hull(e.lo * e.lo, e.lo * e.hi, e.hi * e.hi, e.hi * e.lo));
+      break;
+    default:
+      break;
+    }
+
+    array.elements = values;
+    result.Add(array);
+  }
+  return result;
+}
+
+
+bool RangeAnalysis::Reaches(const State &s, int example_idx) const {
+  const Target &target = targets_[example_idx];
+  if (target.type == Int)  return s.ints.Contains(target.value);
+  return s.has_array && target.length <= s.max_length && s.elements.Contains(target.elements);
+}
+
+
+bool RangeAnalysis::CanReach(IOSet *io, int remaining_steps) const {
+  for (int i = 0; i < io->Size(); i++) {
+    State s = Summarize(io->GetInputs(i));
+    bool reached = false;
+    for (int step = 0; step < remaining_steps && !reached; step++) {
+      s = Step(s);
+      reached = Reaches(s, i);
+    }
+    if (!reached)  return false;
+  }
+  return true;
+}
@@ -0,0 +1,88 @@
+#ifndef _RANGE_ANALYSIS__
+#define _RANGE_ANALYSIS__
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "definitions.h"
+
+class IOSet;
+class ProgramState;
+class RankedOpTable;
+
+using namespace std;
+
+class RangeAnalysis {
+  /*
+   * RangeAnalysis proves that a program prefix cannot be completed into a
+   * solution. For every example it summarizes the registers as an interval
+   * of int values, an interval of array elements and bounds on array
+   * lengths, and applies the ranked ops to that summary once per remaining
+   * step. If the target of some example lies outside the result, no
+   * continuation of the prefix can produce it.
+   *
+   * The transfer functions over-approximate the ops in ops.cc. Results that
+   * might overflow an int widen to the whole int range, so the analysis stays
+   * sound under wrap-around.
+   */
+ public:
+  RangeAnalysis(const RankedOpTable *table, IOSet *io);
+
+  // False if no program of at most remaining_steps more statements can
+  // produce the targets of io from its current registers.
+  bool CanReach(IOSet *io, int remaining_steps) const;
+
+  struct Interval {
+    Interval();
+    Interval(int64_t lo, int64_t hi);
+
+    bool Empty() const;
+    bool Contains(int64_t x) const;
+    bool Contains(const Interval &other) const;
+    void Add(const Interval &other);
+    void Add(int64_t x);
+
+    int64_t lo;
+    int64_t hi;
+  };
+
+  struct State {
+    State();
+
+    void Add(const State &other);
+
+    Interval ints;
+    Interval elements;
+    // Bounds on the lengths of arrays; meaningless if !has_array.
+    int64_t min_length;
+    int64_t max_length;
+    bool has_array;
+  };
+
+ protected:
+  enum OpKind {
+    kUnknown, kIncrement, kDecrement, kMin, kMax, kHeadLast, kSum, kCount,
+    kMapAdd, kMapMult, kMapDiv, kNegate, kSqr, kFilterPos, kFilterNeg, kFilter,
+    kPermute, kScanAdd, kScanSubtract, kScanMult, kScanMinMax, kAccess, kSublist,
+    kZipAdd, kZipSubtract, kZipMult, kZipMinMax
+  };
+
+  State Summarize(ProgramState *ps) const;
+  State Step(const State &s) const;
+  bool Reaches(const State &s, int example_idx) const;
+
+  // Kind of each ranked op, with its constant (e.g. 2 for map_mult2).
+  vector<pair<OpKind, int> > ops_;
+
+  struct Target {
+    DatumType type;
+    int64_t value;
+    int64_t length;
+    Interval elements;
+  };
+  vector<Target> targets_;
+};
+
+#endif
@@ -0,0 +1,406 @@
+#include "ranked_op_table.h"
+#include "ops.h"
+#include "predictions_matrix.h"
+#include "utils.h"
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+
+
+bool SuccPairCompare(pair<double, Successor> a, pair<double, Successor> b) {
+  return (a.first > b.first);
+}
+
+
+RankedOpTable::RankedOpTable() {
+  InitOps();
+  successors_ = ops_;
+}
+
+
+RankedOpTable::RankedOpTable(string order_filename, int sort_and_add_cutoff) {
+  InitOps();
+
+  ifstream f;
+  f.open(order_filename);
+  CHECK(f.is_open(), "Failed to open file " + order_filename);
+
+  map<string, double> name_to_prob;
+
+  double prob;
+  string name;
+  while (f >> prob) {
+    f >> name;
+    name_to_prob.insert(make_pair(name, prob));
+  }
+
+  InitSuccessors(name_to_prob, sort_and_add_cutoff);
+}
+
+
+RankedOpTable::RankedOpTable(const PredictionsMatrix &predictions, int problem_idx,
+                             int sort_and_add_cutoff) {
+  InitOps();
+
+  const float *row = predictions.Row(problem_idx);
+
+  map<string, double> name_to_prob;
+  for (int i = 0; i < predictions.NumComponents(); i++) {
+    name_to_prob.insert(make_pair(predictions.ComponentName(i), row[i]));
+  }
+
+  InitSuccessors(name_to_prob, sort_and_add_cutoff);
+}
+
+
+RankedOpTable::RankedOpTable(const vector<double> &probs, int sort_and_add_cutoff) {
+  InitOps();
+
+  vector<string> names = ComponentNames();
+  CHECK_EQ(probs.size(), names.size(), "Expected one probability per component");
+
+  map<string, double> name_to_prob;
+  for (int i = 0; i < names.size(); i++) {
+    name_to_prob.insert(make_pair(names[i], probs[i]));
+  }
+
+  InitSuccessors(name_to_prob, sort_and_add_cutoff);
+}
+
+
+const RankedOpTable *RankedOpTable::Shared(string order_filename, int sort_and_add_cutoff) {
+  static mutex tables_mutex;
+  static map<pair<string, int>, RankedOpTable *> tables;
+
+  lock_guard<mutex> lock(tables_mutex);
+  auto key = make_pair(order_filename, sort_and_add_cutoff);
+  auto it = tables.find(key);
+  if (it == tables.end()) {
+    it = tables.insert(make_pair(key, new RankedOpTable(order_filename, sort_and_add_cutoff))).first;
+  }
+  return it->second;
+}
+
+
+const vector<Successor> &RankedOpTable::Successors() const {
+  return successors_;
+}
+
+
+int RankedOpTable::NumOps() const {
+  return ops_.size();
+}
+
+
+const Successor &RankedOpTable::Op(int id) const {
+  return ops_[id];
+}
+
+
+int RankedOpTable::OpId(string name) const {
+  for (auto &op : ops_) {
+    if (op.Name() == name)  return op.Id();
+  }
+  return -1;
+}
+
+
+void RankedOpTable::InitOps() {
+  // int to int ops
+  if (false) {  // Matej doesn't use these
+    ops_.push_back(Successor("increment", increment, Int, Int));
+    ops_.push_back(Successor("decrement", decrement, Int, Int));
+  }
+
+  // int[] to int ops
+  if (true) {  // element selection
+    ops_.push_back(Successor("arr_min", arr_min, Array, Int));
+    ops_.push_back(Successor("arr_max", arr_max, Array, Int));
+    ops_.push_back(Successor("arr_head", arr_head, Array, Int));
+    ops_.push_back(Successor("arr_last", arr_last, Array, Int));
+    ops_.push_back(Successor("arr_sum", arr_sum, Array, Int));
+  }
+
+  if (true) {  // counting
+    ops_.push_back(Successor("count_is_pos", count_is_pos, Array, Int));
+    ops_.push_back(Successor("count_is_neg", count_is_neg, Array, Int));
+    ops_.push_back(Successor("count_is_even", count_is_even, Array, Int));
+    ops_.push_back(Successor("count_is_odd", count_is_odd, Array, Int));
+  }
+
+  // int[] to int[] ops
+  if (true) {  // maps
+    ops_.push_back(Successor("map_increment", map_increment, Array, Array));
+    ops_.push_back(Successor("map_decrement", map_decrement, Array, Array));
+    ops_.push_back(Successor("map_mult2", map_mult2, Array, Array));
+    ops_.push_back(Successor("map_div2", map_div2, Array, Array));
+    ops_.push_back(Successor("map_negate", map_negate, Array, Array));
+    ops_.push_back(Successor("map_sqr", map_sqr, Array, Array));
+    ops_.push_back(Successor("map_mult3", map_mult3, Array, Array));
+    ops_.push_back(Successor("map_div3", map_div3, Array, Array));
+    ops_.push_back(Successor("map_mult4", map_mult4, Array, Array));
+    ops_.push_back(Successor("map_div4", map_div4, Array, Array));
+  }
+
+  if (true) {  // filters
+    ops_.push_back(Successor("filter_is_pos", filter_is_pos, Array, Array));
+    ops_.push_back(Successor("filter_is_neg", filter_is_neg, Array, Array));
+    ops_.push_back(Successor("filter_is_odd", filter_is_odd, Array, Array));
+    ops_.push_back(Successor("filter_is_even", filter_is_even, Array, Array));
+  }
+
+  if (true) {  // sort and reverse
+    ops_.push_back(Successor("sort", sort_datum, Array, Array));
+    ops_.push_back(Successor("reverse", reverse_datum, Array, Array));
+  }
+
+  if (true) {  // scanl
+    ops_.push_back(Successor("scanl_add", scanl_add, Array, Array));
+    ops_.push_back(Successor("scanl_subtract", scanl_subtract, Array, Array));
+    ops_.push_back(Successor("scanl_mult", scanl_mult, Array, Array));
+    ops_.push_back(Successor("scanl_max", scanl_max, Array, Array));
+    ops_.push_back(Successor("scanl_min", scanl_min, Array, Array));
+  }
+
+  if (true) {
+    ops_.push_back(Successor("access", access, Int, Array, Int));
+  }
+  // int[] x int[] to int[] ops
+  if (true) {
+    ops_.push_back(Successor("take", take, Int, Array, Array));
+    ops_.push_back(Successor("drop", drop, Int, Array, Array));
+  }
+
+  // int[] x int[] to int[] ops
+  if (true) {
+    ops_.push_back(Successor("zipwith_add", zipwith_add, Array, Array, Array));
+    ops_.push_back(Successor("zipwith_subtract", zipwith_subtract, Array, Array, Array));
+    ops_.push_back(Successor("zipwith_mult", zipwith_mult, Array, Array, Array));
+    ops_.push_back(Successor("zipwith_max", zipwith_max, Array, Array, Array));
+    ops_.push_back(Successor("zipwith_min", zipwith_min, Array, Array, Array));
+  }
+
+  for (int i = 0; i < ops_.size(); i++)  ops_[i].id_ = i;
+  InitRules();
+}
+
+
+// The properties hold for every int value, including overflowing ones
+// (ints wrap around) and empty arrays, e.g. arr_head and arr_min of sort
+// differ on empty arrays and map_div2 of map_mult2 on overflow, so neither
+// is listed.
+void RankedOpTable::InitRules() {
+  vector<string> filters = {"filter_is_pos", "filter_is_neg", "filter_is_odd", "filter_is_even"};
+  vector<string> maps = {"map_increment", "map_decrement", "map_mult2", "map_div2", "map_negate",
+                         "map_sqr", "map_mult3", "map_div3", "map_mult4", "map_div4"};
+  vector<string> order_free = {"arr_min", "arr_max", "arr_sum", "count_is_pos", "count_is_neg",
+                               "count_is_odd", "count_is_even"};
+
+  // f(f(x)) = f(x)
+  vector<string> idempotent = {"sort", "scanl_max", "scanl_min"};
+  idempotent.insert(idempotent.end(), filters.begin(), filters.end());
+  // f(f(x)) = x
+  vector<string> involutive = {"reverse", "map_negate"};
+  // f(g(x)) = x
+  vector<pair<string, string> > inverses = {
+    {"map_increment", "map_decrement"}, {"map_decrement", "map_increment"}};
+  // f(g(x)) = f(x)
+  vector<pair<string, string> > absorbs = {{"sort", "reverse"}};
+  for (auto &f : order_free) {
+    absorbs.push_back(make_pair(f, "reverse"));
+    absorbs.push_back(make_pair(f, "sort"));
+  }
+  absorbs.push_back(make_pair("arr_max", "scanl_max"));
+  absorbs.push_back(make_pair("arr_min", "scanl_min"));
+  // f(g(x)) = g(x)
+  vector<pair<string, string> > absorbed_by = {
+    {"scanl_max", "sort"}, {"filter_is_even", "map_mult2"}, {"filter_is_even", "map_mult4"}};
+  // f(g(x)) = h(x) for another op h
+  vector<pair<string, string> > collapses = {{"arr_head", "reverse"}, {"arr_last", "reverse"}};
+  // f(g(x)) = g(f(x))
+  vector<pair<string, string> > commutes;
+  for (auto &f : filters) {
+    commutes.push_back(make_pair(f, "reverse"));
+    commutes.push_back(make_pair(f, "sort"));
+    for (auto &g : filters) {
+      if (f != g)  commutes.push_back(make_pair(f, g));
+    }
+  }
+  for (auto &f : maps)  commutes.push_back(make_pair(f, "reverse"));
+  vector<string> mults = {"map_mult2", "map_mult3", "map_mult4"};
+  vector<string> divs = {"map_div2", "map_div3", "map_div4"};
+  for (auto group : {mults, divs}) {
+    for (auto &f : group) {
+      for (auto &g : group) {
+        if (f != g)  commutes.push_back(make_pair(f, g));
+      }
+    }
+  }
+  for (auto &f : divs)  commutes.push_back(make_pair(f, "sort"));
+
+  int n = ops_.size();
+  rewrites_.assign(n * n, kNoRewrite);
+  auto set = [this, n](string f, string g, Rewrite rewrite) {
+    int f_id = OpId(f), g_id = OpId(g);
+    CHECK(f_id >= 0 && g_id >= 0, "Unknown op in the rewrite rules: " + f + " or " + g);
+    rewrites_[f_id * n + g_id] = rewrite;
+  };
+  for (auto &f : idempotent)  set(f, f, kRedundant);
+  for (auto &f : involutive)  set(f, f, kCancels);
+  for (auto &fg : inverses)  set(fg.first, fg.second, kCancels);
+  for (auto &fg : absorbs)  set(fg.first, fg.second, kRedundant);
+  for (auto &fg : absorbed_by)  set(fg.first, fg.second, kRedundant);
+  for (auto &fg : collapses)  set(fg.first, fg.second, kRedundant);
+  set("take", "take", kSameCount);
+  // Of the two orders, the one with the op of smaller id outside is skipped.
+  for (auto &fg : commutes) {
+    if (OpId(fg.first) < OpId(fg.second)) {
+      set(fg.first, fg.second, kCommutes);
+    } else {
+      set(fg.second, fg.first, kCommutes);
+    }
+  }
+
+  commutative_.assign(n, false);
+  idempotent_on_pairs_.assign(n, false);
+  for (string f : {"zipwith_add", "zipwith_mult", "zipwith_max", "zipwith_min"}) {
+    commutative_[OpId(f)] = true;
+  }
+  for (string f : {"zipwith_max", "zipwith_min"})  idempotent_on_pairs_[OpId(f)] = true;
+
+  has_rules_.assign(n, false);
+  for (int f = 0; f < n; f++) {
+    has_rules_[f] = commutative_[f] || idempotent_on_pairs_[f];
+    for (int g = 0; g < n; g++)  has_rules_[f] = has_rules_[f] || GetRewrite(f, g) != kNoRewrite;
+  }
+}
+
+
+// The DSL components of the data files (prior.txt, predictions) that make
+// up each op. An op's probability is the minimum over its components.
+static const map<string, vector<string> > &OpComponents() {
+  static const map<string, vector<string> > components = [] {
+    string ZIPWITH = "ZIPWITH";
+    string TIMES = "*";
+    string MAP = "MAP";
+    string SQR = "SQR";
+    string MUL4 = "MUL4";
+    string DIV4 = "DIV4";
+    string MINUS = "-";
+    string MUL3 = "MUL3";
+    string DIV3 = "DIV3";
+    string MIN = "MIN";
+    string PLUS = "+";
+    string SCANL = "SCANL";
+    string SHR = "SHR";
+    string SHL = "SHL";
+    string MAX = "MAX";
+    string HEAD = "HEAD";
+    string DEC = "DEC";
+    string SUM = "SUM";
+    string doNEG = "doNEG";
+    string isNEG = "isNEG";
+    string INC = "INC";
+    string LAST = "LAST";
+    string MINIMUM = "MINIMUM";
+    string isPOS = "isPOS";
+    string SORT = "SORT";
+    string FILTER = "FILTER";
+    string isODD = "isODD";
+    string REVERSE = "REVERSE";
+    string ACCESS = "ACCESS";
+    string isEVEN = "isEVEN";
+    string COUNT = "COUNT";
+    string TAKE = "TAKE";
+    string MAXIMUM = "MAXIMUM";
+    string DROP = "DROP";
+
+    map<string, vector<string> > components;
+    components["arr_min"] = vector<string>({MINIMUM});
+    components["arr_max"] = vector<string>({MAXIMUM});
+    components["arr_head"] = vector<string>({HEAD});
+    components["arr_last"] = vector<string>({LAST});
+    components["arr_sum"] = vector<string>({MAP, SUM});
+
+    components["count_is_pos"] = vector<string>({COUNT, isPOS});
+    components["count_is_neg"] = vector<string>({COUNT, isNEG});
+    components["count_is_even"] = vector<string>({COUNT, isEVEN});
+    components["count_is_odd"] = vector<string>({COUNT, isODD});
+
+    components["filter_is_pos"] = vector<string>({FILTER, isPOS});
+    components["filter_is_neg"] = vector<string>({FILTER, isNEG});
+    components["filter_is_even"] = vector<string>({FILTER, isEVEN});
+    components["filter_is_odd"] = vector<string>({FILTER, isODD});
+
+    components["map_increment"] = vector<string>({MAP, INC});
+    components["map_decrement"] = vector<string>({MAP, INC});
+    components["map_mult2"] = vector<string>({MAP, SHL});
+    components["map_div2"] = vector<string>({MAP, SHR});
+    components["map_negate"] = vector<string>({MAP, doNEG});
+    components["map_sqr"] = vector<string>({MAP, SQR});
+    components["map_mult3"] = vector<string>({MAP, MUL3});
+    components["map_div3"] = vector<string>({MAP, DIV3});
+    components["map_mult4"] = vector<string>({MAP, MUL4});
+    components["map_div4"] = vector<string>({MAP, DIV4});
+
+    components["sort"] = vector<string>({SORT});
+    components["reverse"] = vector<string>({REVERSE});
+
+    components["take"] = vector<string>({TAKE});
+    components["drop"] = vector<string>({DROP});
+    components["access"] = vector<string>({ACCESS});
+
+    components["scanl_add"] = vector<string>({SCANL, PLUS});
+    components["scanl_subtract"] = vector<string>({SCANL, MINUS});
+    components["scanl_mult"] = vector<string>({SCANL, TIMES});
+    components["scanl_max"] = vector<string>({SCANL, MAX});
+    components["scanl_min"] = vector<string>({SCANL, MIN});
+
+    components["zipwith_add"] = vector<string>({ZIPWITH, PLUS});
+    components["zipwith_subtract"] = vector<string>({ZIPWITH, MINUS});
+    components["zipwith_mult"] = vector<string>({ZIPWITH, TIMES});
+    components["zipwith_max"] = vector<string>({ZIPWITH, MAX});
+    components["zipwith_min"] = vector<string>({ZIPWITH, MIN});
+    return components;
+  }();
+  return components;
+}
+
+
+vector<string> RankedOpTable::Components(string op_name) {
+  auto it = OpComponents().find(op_name);
+  if (it == OpComponents().end())  return vector<string>();
+  return it->second;
+}
+
+
+vector<string> RankedOpTable::ComponentNames() {
+  return vector<string>({
+      "ZIPWITH", "*", "MAP", "SQR", "MUL4", "DIV4", "-", "MUL3", "DIV3", "MIN", "+",
+      "SCANL", "SHR", "SHL", "MAX", "HEAD", "DEC", "SUM", "doNEG", "isNEG", "INC",
+      "LAST", "MINIMUM", "isPOS", "SORT", "FILTER", "isODD", "REVERSE", "ACCESS",
+      "isEVEN", "COUNT", "TAKE", "MAXIMUM", "DROP"});
+}
+
+
+void RankedOpTable::InitSuccessors(map<string, double> &name_to_prob, int sort_and_add_cutoff) {
+  vector<pair<double, Successor> > weighted_successors;
+  for (auto &succ : ops_) {
+    double prob = 1.0;
+    for (auto &component : Components(succ.Name())) {
+      prob = min(prob, name_to_prob[component]);
+    }
+    //if (prob >= 0)
+    weighted_successors.push_back(make_pair(prob, succ));
+  }
+
+  sort(weighted_successors.begin(), weighted_successors.end(), SuccPairCompare);
+
+  int ii = 0;
+  for (auto &p : weighted_successors) {
+    //cout << p.first << " " << p.second.Name() << endl;
+    if ((sort_and_add_cutoff == -1) || (ii < sort_and_add_cutoff))
+      successors_.push_back(p.second);
+    ii++;
+  }
+}
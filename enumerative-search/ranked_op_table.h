@@ -0,0 +1,99 @@
+#ifndef _RANKED_OP_TABLE__
+#define _RANKED_OP_TABLE__
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "definitions.h"
+#include "successor.h"
+
+class PredictionsMatrix;
+
+using namespace std;
+
+class RankedOpTable {
+  /*
+   * RankedOpTable holds the DSL ops the search can apply (see InitOps) and
+   * the order in which SuccessorIterators should try them. The order comes
+   * from an ordering file or a row of a predictions matrix, and is cut off
+   * after the sort_and_add_cutoff most likely ops.
+   *
+   * A table is immutable once built. One table is shared by all iterators
+   * of a search, so the ordering is parsed and sorted once per problem, or
+   * once per process for dataset-wide orderings (see Shared()).
+   */
+ public:
+  // All ops in InitOps order, without ranking or cutoff.
+  RankedOpTable();
+  RankedOpTable(string order_filename, int sort_and_add_cutoff);
+  RankedOpTable(const PredictionsMatrix &predictions, int problem_idx,
+                int sort_and_add_cutoff);
+  // probs holds one probability per component, in ComponentNames() order.
+  RankedOpTable(const vector<double> &probs, int sort_and_add_cutoff);
+
+  // Returns a process-wide table for a dataset-wide ordering file such as
+  // prior.txt, building it on first use. Safe to call from several threads.
+  static const RankedOpTable *Shared(string order_filename, int sort_and_add_cutoff);
+
+  // Ranked ops, most likely first.
+  const vector<Successor> &Successors() const;
+
+  // All ops, indexed by Successor::Id().
+  int NumOps() const;
+  const Successor &Op(int id) const;
+  int OpId(string name) const;
+
+  // How an op applied to a register relates to the op that produced it,
+  // from the algebraic properties declared in InitRules. A statement with
+  // a rewrite computes a value that a program of the same length or shorter
+  // also computes, so the search can skip it (see SuccessorIterator).
+  enum Rewrite {
+    kNoRewrite,
+    // f(g(x)) is g(x), or some op applied to x.
+    kRedundant,
+    // f(g(x)) is x.
+    kCancels,
+    // f(n, g(n, x)) is g(n, x), for the same int register n.
+    kSameCount,
+    // f(g(x)) is g(f(x)); only this order of the two is kept.
+    kCommutes
+  };
+  inline Rewrite GetRewrite(int op_id, int producer_id) const {
+    return rewrites_[op_id * ops_.size() + producer_id];
+  }
+  // f(x, y) is f(y, x).
+  inline bool Commutative(int op_id) const {
+    return commutative_[op_id];
+  }
+  // f(x, x) is x.
+  inline bool IdempotentOnPairs(int op_id) const {
+    return idempotent_on_pairs_[op_id];
+  }
+  // Whether any of the above applies to the op.
+  inline bool HasRules(int op_id) const {
+    return has_rules_[op_id];
+  }
+
+  // Names of the DSL components used by ordering files, in prior.txt order,
+  // and the components that make up an op.
+  static vector<string> ComponentNames();
+  static vector<string> Components(string op_name);
+
+ protected:
+  void InitOps();
+  void InitRules();
+  void InitSuccessors(map<string, double> &name_to_prob, int sort_and_add_cutoff);
+
+  vector<Successor> ops_;
+  vector<Successor> successors_;
+
+  // By op_id * NumOps() + producer_id.
+  vector<Rewrite> rewrites_;
+  vector<bool> commutative_;
+  vector<bool> idempotent_on_pairs_;
+  vector<bool> has_rules_;
+};
+
+#endif
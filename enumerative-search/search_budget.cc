@@ -0,0 +1,46 @@
+#include "search_budget.h"
+#include "search_options.h"
+#include <sys/resource.h>
+
+
+SearchBudget::SearchBudget(const SearchOptions &options) :
+  max_secs_(options.max_secs),
+  max_nodes_(options.max_nodes),
+  max_mem_mb_(options.max_mem_mb)
+{}
+
+
+void SearchBudget::Start() {
+  reason_ = "";
+  timer_.tic();
+}
+
+
+void SearchBudget::SetCancelCheck(function<bool()> cancelled) {
+  cancelled_ = cancelled;
+}
+
+
+string SearchBudget::Reason() const {
+  return reason_;
+}
+
+
+bool SearchBudget::CheckLimits(long num_nodes_explored) {
+  if (max_nodes_ > 0 && num_nodes_explored >= max_nodes_) {
+    reason_ = "max_nodes";
+  }
+  if (max_secs_ > 0) {
+    double real_secs;
+    timer_.toc(false, NULL, &real_secs);
+    if (real_secs >= max_secs_)  reason_ = "max_secs";
+  }
+  if (max_mem_mb_ > 0) {
+    // Peak resident set size, in kilobytes on Linux.
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    if (usage.ru_maxrss / 1024 >= max_mem_mb_)  reason_ = "max_mem_mb";
+  }
+  if (cancelled_ && cancelled_())  reason_ = "cancelled";
+  return !reason_.empty();
+}
@@ -0,0 +1,54 @@
+#ifndef _SEARCH_BUDGET__
+#define _SEARCH_BUDGET__
+
+#include <functional>
+#include <string>
+
+#include "utils.h"
+
+struct SearchOptions;
+
+using namespace std;
+
+class SearchBudget {
+  /*
+   * SearchBudget enforces the per-problem limits on wall time, nodes
+   * explored and memory given in SearchOptions. Exhausted() is cheap enough
+   * to call on every node: the clock and memory usage are only looked at
+   * once every kCheckInterval nodes.
+   */
+ public:
+  SearchBudget(const SearchOptions &options);
+
+  // Starts the wall clock.
+  void Start();
+
+  inline bool Exhausted(long num_nodes_explored) {
+    if ((num_nodes_explored & (kCheckInterval - 1)) != 0)  return false;
+    return CheckLimits(num_nodes_explored);
+  }
+
+  // Checks every limit now.
+  bool CheckLimits(long num_nodes_explored);
+
+  // Also stops the search, with reason "cancelled", once cancelled()
+  // returns true. It is called as often as the limits are checked.
+  void SetCancelCheck(function<bool()> cancelled);
+
+  // Which limit was hit, or "" if none was.
+  string Reason() const;
+
+  static const long kCheckInterval = 1024;
+
+ protected:
+
+  double max_secs_;
+  long max_nodes_;
+  long max_mem_mb_;
+  function<bool()> cancelled_;
+
+  MyTimer timer_;
+  string reason_;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "search_cache.h"
+#include "datum.h"
+#include "io_set.h"
+#include "program_state.h"
+#include "utils.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static const string kCacheMagic = "DCCACHE1";
+
+
+// FNV-1a.
+static uint64_t HashKey(const string &s) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : s) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+
+// Multiply-xorshift, unrelated to HashKey so that a collision of one is
+// unlikely to be a collision of the other.
+static uint64_t HashCheck(const string &s) {
+  uint64_t hash = 0x9E3779B97F4A7C15ULL;
+  for (unsigned char c : s) {
+    hash = (hash ^ c) * 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 31;
+  }
+  return hash;
+}
+
+
+static string Hex(uint64_t x) {
+  stringstream ss;
+  ss << hex << setw(16) << setfill('0') << x;
+  return ss.str();
+}
+
+
+CachedResult::CachedResult() :
+  solved(false), nodes_explored(0), secs(0)
+{}
+
+
+SearchCache::SearchCache(string dir_name, IOSet *io, string config) :
+  dir_name_(dir_name)
+{
+  // Examples are sorted, so that the key does not depend on their order.
+  vector<string> examples;
+  for (int i = 0; i < io->Size(); i++) {
+    stringstream ss;
+    ss << *io->GetInputs(i) << "-> " << *io->GetOutput(i);
+    examples.push_back(ss.str());
+  }
+  sort(examples.begin(), examples.end());
+
+  string key;
+  for (auto &example : examples)  key += example + "\n";
+  key += "#\n" + config;
+
+  key_ = HashKey(key);
+  check_ = HashCheck(key);
+}
+
+
+string SearchCache::Filename() const {
+  return dir_name_ + "/" + Hex(key_) + ".result";
+}
+
+
+bool SearchCache::Lookup(CachedResult *result) const {
+  ifstream file(Filename());
+  if (!file.is_open())  return false;
+
+  string magic, check;
+  file >> magic >> check;
+  if (magic != kCacheMagic || check != Hex(check_))  return false;
+
+  string field;
+  int num_solutions;
+  CachedResult r;
+  file >> field >> r.solved >> field >> r.nodes_explored >> field >> r.secs
+       >> field >> num_solutions;
+  for (int i = 0; file && i < num_solutions; i++) {
+    int num_lines;
+    file >> num_lines;
+    file.ignore();
+    string solution, line;
+    for (int j = 0; j < num_lines && getline(file, line); j++)  solution += line + "\n";
+    r.solutions.push_back(solution);
+  }
+  if (!file)  return false;
+
+  *result = r;
+  return true;
+}
+
+
+void SearchCache::Store(const CachedResult &result) const {
+  mkdir(dir_name_.c_str(), 0777);
+
+  string filename = Filename();
+  string tmp_filename = filename + ".tmp" + to_string(getpid());
+  ofstream file(tmp_filename);
+  if (!file.is_open())  return;
+
+  file << kCacheMagic << " " << Hex(check_) << endl;
+  file << "solved " << result.solved << endl;
+  file << "nodes_explored " << result.nodes_explored << endl;
+  file << "secs " << setprecision(9) << result.secs << endl;
+  file << "solutions " << result.solutions.size() << endl;
+  for (auto &solution : result.solutions) {
+    file << count(solution.begin(), solution.end(), '\n') << endl << solution;
+  }
+  file.close();
+
+  if (file.fail() || rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    unlink(tmp_filename.c_str());
+  }
+}
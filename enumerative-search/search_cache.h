@@ -0,0 +1,53 @@
+#ifndef _SEARCH_CACHE__
+#define _SEARCH_CACHE__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "definitions.h"
+
+class IOSet;
+
+using namespace std;
+
+struct CachedResult {
+  CachedResult();
+
+  bool solved;
+  long nodes_explored;
+  double secs;
+  // Solutions in the format of the search output, " %k <- op %i %j" per line.
+  vector<string> solutions;
+};
+
+
+class SearchCache {
+  /*
+   * SearchCache stores search results on disk, one file per problem in a
+   * cache directory. Results are keyed by a fingerprint of the examples of
+   * the IOSet, which does not depend on their order, and a description of
+   * the search config. The file name is one 64 bit hash of the key and the
+   * file records a second, independent hash, so that a collision of the
+   * first is detected and treated as a miss.
+   *
+   * Files are written to a temporary name and renamed into place, so that
+   * any number of searches on one machine can share a cache directory: a
+   * reader sees either no file or a complete one.
+   */
+ public:
+  SearchCache(string dir_name, IOSet *io, string config);
+
+  bool Lookup(CachedResult *result) const;
+  // Best effort: failures to write the cache are ignored.
+  void Store(const CachedResult &result) const;
+
+  string Filename() const;
+
+ protected:
+  string dir_name_;
+  uint64_t key_;
+  uint64_t check_;
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include "search_checkpoint.h"
+#include "ranked_op_table.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <unistd.h>
+
+
+static const string kCheckpointMagic = "DCCKPT1";
+
+
+SearchCheckpoint::SearchCheckpoint(string filename, double interval_secs, string config) :
+  pass(0),
+  num_nodes_explored(0),
+  num_nodes_pruned(0),
+  secs(0),
+  filename_(filename),
+  interval_secs_(interval_secs),
+  config_(config),
+  last_save_secs_(0)
+{
+  // The config is stored on one line.
+  replace(config_.begin(), config_.end(), '\n', ';');
+  timer_.tic();
+}
+
+
+string SearchCheckpoint::Filename() const {
+  return filename_;
+}
+
+
+double SearchCheckpoint::Elapsed() {
+  double secs_taken;
+  timer_.toc(false, NULL, &secs_taken);
+  return secs_taken;
+}
+
+
+bool SearchCheckpoint::Load(const RankedOpTable *table) {
+  ifstream file(filename_);
+  if (!file.is_open())  return false;
+
+  string magic, field, config;
+  file >> magic >> field;
+  file.ignore();
+  getline(file, config);
+  CHECK(magic == kCheckpointMagic, filename_ + " is not a search checkpoint");
+  CHECK(config == config_, filename_ + " is the checkpoint of another problem or config");
+
+  int num_positions, num_depths, num_solutions;
+  file >> field >> pass >> field >> num_positions;
+  positions.resize(num_positions);
+  for (auto &position : positions)  file >> position;
+  file >> field >> num_nodes_explored >> field >> num_nodes_pruned >> field >> num_depths;
+  nodes_per_depth.resize(num_depths);
+  for (auto &n : nodes_per_depth)  file >> n;
+  file >> field >> secs >> field >> num_solutions;
+
+  // Statements are "op_id arg1 arg2", arg2 being unused by one-argument ops.
+  solutions.clear();
+  for (int i = 0; file && i < num_solutions; i++) {
+    int length;
+    file >> length;
+    solutions.push_back(vector<Successor>());
+    for (int j = 0; file && j < length; j++) {
+      int op_id, arg1, arg2;
+      file >> op_id >> arg1 >> arg2;
+      CHECK(op_id >= 0 && op_id < table->NumOps(), filename_ + " has an unknown op");
+      Successor statement = table->Op(op_id);
+      if (statement.IsOp1()) {
+        statement.SetOp1Arg(arg1);
+      } else {
+        statement.SetOp2Args(arg1, arg2);
+      }
+      solutions.back().push_back(statement);
+    }
+  }
+  CHECK(!file.fail() && !positions.empty(), filename_ + " is truncated");
+  return true;
+}
+
+
+bool SearchCheckpoint::Due() {
+  return Elapsed() - last_save_secs_ >= interval_secs_;
+}
+
+
+void SearchCheckpoint::Save() {
+  last_save_secs_ = Elapsed();
+
+  string tmp_filename = filename_ + ".tmp" + to_string(getpid());
+  ofstream file(tmp_filename);
+  CHECK(file.is_open(), "Failed to create file " + tmp_filename);
+
+  file << kCheckpointMagic << endl;
+  file << "config " << config_ << endl;
+  file << "pass " << pass << endl;
+  file << "positions " << positions.size();
+  for (auto position : positions)  file << " " << position;
+  file << endl;
+  file << "nodes_explored " << num_nodes_explored << endl;
+  file << "nodes_pruned " << num_nodes_pruned << endl;
+  file << "nodes_per_depth " << nodes_per_depth.size();
+  for (auto n : nodes_per_depth)  file << " " << n;
+  file << endl;
+  file << "secs " << setprecision(9) << secs + last_save_secs_ << endl;
+  file << "solutions " << solutions.size() << endl;
+  for (auto &solution : solutions) {
+    file << solution.size();
+    for (auto &statement : solution) {
+      CHECK(statement.Id() >= 0, "Cannot checkpoint a solution with ops not from the table");
+      if (statement.IsOp1()) {
+        file << " " << statement.Id() << " " << statement.GetOp1Arg() << " -1";
+      } else {
+        file << " " << statement.Id() << " " << statement.GetOp2Arg1() << " "
+             << statement.GetOp2Arg2();
+      }
+    }
+    file << endl;
+  }
+  file.close();
+  CHECK(!file.fail(), "Failed to write " + tmp_filename);
+
+  int renamed = rename(tmp_filename.c_str(), filename_.c_str());
+  CHECK(renamed == 0, "Failed to write checkpoint " + filename_);
+}
+
+
+void SearchCheckpoint::Remove() {
+  unlink(filename_.c_str());
+}
@@ -0,0 +1,62 @@
+#ifndef _SEARCH_CHECKPOINT__
+#define _SEARCH_CHECKPOINT__
+
+#include <string>
+#include <vector>
+
+#include "successor.h"
+#include "utils.h"
+
+class RankedOpTable;
+
+using namespace std;
+
+class SearchCheckpoint {
+  /*
+   * SearchCheckpoint keeps the state of a DepthFirstSearch in a file, so
+   * that a search killed part way can be resumed. The state is small: the
+   * positions of the iterators along the current path, from which the
+   * registers are rebuilt by replaying the path, the counters and the
+   * solutions found so far. It also records the pass of a bidirectional
+   * search and a description of the problem and config, and only resumes
+   * a search that has the same.
+   *
+   * Files are written to a temporary name and renamed into place, so that
+   * a search killed while saving leaves the previous checkpoint.
+   */
+ public:
+  // Saves to filename at most every interval_secs seconds (see Due).
+  SearchCheckpoint(string filename, double interval_secs, string config);
+
+  // Reads the file into the fields below. Returns false if there is no
+  // checkpoint; CHECK-fails if it belongs to another search.
+  bool Load(const RankedOpTable *table);
+  // Whether interval_secs have passed since the last Save.
+  bool Due();
+  void Save();
+  // Removes the file of a search that finished.
+  void Remove();
+
+  string Filename() const;
+
+  int pass;
+  // Position() of the iterators from depth 0 to the current depth.
+  vector<int> positions;
+  long num_nodes_explored;
+  long num_nodes_pruned;
+  vector<long> nodes_per_depth;
+  // Search time of the runs before this one.
+  double secs;
+  vector<vector<Successor> > solutions;
+
+ protected:
+  double Elapsed();
+
+  string filename_;
+  double interval_secs_;
+  string config_;
+  MyTimer timer_;
+  double last_save_secs_;
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "search_coordinator.h"
+#include "line_socket.h"
+#include "search_budget.h"
+#include "utils.h"
+#include <poll.h>
+#include <sstream>
+#include <unistd.h>
+
+
+// How long to wait for messages before checking the budget again.
+static const int kPollMs = 100;
+
+
+SearchCoordinator::SearchCoordinator(int port, string config, SearchBudget *budget) :
+  config_(config),
+  budget_(budget),
+  num_workers_seen_(0),
+  pass_(0),
+  num_running_(0),
+  stopping_(false),
+  solved_(false),
+  num_nodes_explored_(0),
+  num_nodes_pruned_(0)
+{
+  listen_fd_ = LineSocket::Listen(port);
+  cout << "Waiting for workers on port " << port << endl;
+}
+
+
+SearchCoordinator::~SearchCoordinator() {
+  for (auto &worker : workers_) {
+    if (worker.ready)  worker.socket->WriteLine("DONE");
+    delete worker.socket;
+  }
+  close(listen_fd_);
+}
+
+
+void SearchCoordinator::Run(int pass, const vector<vector<int> > &tasks) {
+  pass_ = pass;
+  tasks_ = tasks;
+  pending_.clear();
+  for (int i = 0; i < tasks_.size(); i++)  pending_.push_back(i);
+
+  while ((!stopping_ && !pending_.empty()) || num_running_ > 0) {
+    for (auto &worker : workers_) {
+      if (!worker.ready || stopping_ || pending_.empty())  continue;
+      worker.task = pending_.front();
+      pending_.pop_front();
+      worker.ready = false;
+      num_running_++;
+
+      string line = "TASK " + to_string(worker.task) + " " + to_string(pass_);
+      for (auto position : tasks_[worker.task])  line += " " + to_string(position);
+      // A worker that is gone is noticed when reading from it.
+      worker.socket->WriteLine(line);
+    }
+
+    vector<struct pollfd> fds(1, {listen_fd_, POLLIN, 0});
+    for (auto &worker : workers_)  fds.push_back({worker.socket->Fd(), POLLIN, 0});
+    poll(fds.data(), fds.size(), kPollMs);
+
+    for (int i = workers_.size() - 1; i >= 0; i--) {
+      if (fds[i + 1].revents == 0 || Receive(workers_[i]))  continue;
+      // Tasks of lost workers are handed out again.
+      if (workers_[i].task >= 0) {
+        num_running_--;
+        if (!stopping_)  pending_.push_front(workers_[i].task);
+      }
+      delete workers_[i].socket;
+      workers_.erase(workers_.begin() + i);
+    }
+    if (fds[0].revents & POLLIN)  Accept();
+
+    if (!stopping_ && budget_->CheckLimits(num_nodes_explored_))  Stop(budget_->Reason());
+  }
+}
+
+
+void SearchCoordinator::Accept() {
+  LineSocket *socket = LineSocket::Accept(listen_fd_);
+  if (socket == NULL)  return;
+  workers_.push_back({socket, false, -1});
+  num_workers_seen_++;
+}
+
+
+bool SearchCoordinator::Receive(Worker &worker) {
+  if (!worker.socket->Receive())  return false;
+  string line;
+  while (worker.socket->NextLine(line)) {
+    if (!HandleLine(worker, line))  return false;
+  }
+  return true;
+}
+
+
+bool SearchCoordinator::HandleLine(Worker &worker, const string &line) {
+  stringstream ss(line);
+  string command;
+  ss >> command;
+
+  if (command == "HELLO") {
+    if (line.substr(min(line.size(), (size_t) 6)) != config_) {
+      cerr << "Rejected a worker with a different configuration" << endl;
+      worker.socket->WriteLine("ERROR configuration differs from the coordinator's");
+      return false;
+    }
+  } else if (command == "READY") {
+    if (stopping_) {
+      worker.socket->WriteLine("DONE");
+    } else {
+      worker.ready = true;
+    }
+  } else if (command == "RESULT") {
+    int task = -1, num_lines = 0;
+    long num_nodes_explored = 0, num_nodes_pruned = 0;
+    string status;
+    ss >> task >> status >> num_nodes_explored >> num_nodes_pruned >> num_lines;
+    if (ss.fail() || task != worker.task)  return false;
+
+    string program, program_line;
+    for (int i = 0; i < num_lines; i++) {
+      if (!worker.socket->ReadLine(program_line))  return false;
+      program += program_line + "\n";
+    }
+    worker.task = -1;
+    num_running_--;
+    num_nodes_explored_ += num_nodes_explored;
+    num_nodes_pruned_ += num_nodes_pruned;
+
+    if (status == "solved") {
+      if (!solved_)  solution_programs_.push_back(program);
+      solved_ = true;
+      Stop("");
+    } else if (status.compare(0, 8, "stopped:") == 0) {
+      Stop("worker " + status.substr(8));
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+
+void SearchCoordinator::Stop(string reason) {
+  if (reason_.empty())  reason_ = reason;
+  if (stopping_)  return;
+  stopping_ = true;
+  for (auto &worker : workers_) {
+    if (worker.task >= 0)  worker.socket->WriteLine("CANCEL");
+    if (worker.ready)  worker.socket->WriteLine("DONE");
+    worker.ready = false;
+  }
+}
+
+
+bool SearchCoordinator::Solved() const {
+  return solved_;
+}
+
+
+const vector<string> &SearchCoordinator::SolutionPrograms() const {
+  return solution_programs_;
+}
+
+
+long SearchCoordinator::NumNodesExplored() const {
+  return num_nodes_explored_;
+}
+
+
+long SearchCoordinator::NumNodesPruned() const {
+  return num_nodes_pruned_;
+}
+
+
+int SearchCoordinator::NumWorkers() const {
+  return num_workers_seen_;
+}
+
+
+string SearchCoordinator::Reason() const {
+  return reason_;
+}
@@ -0,0 +1,85 @@
+#ifndef _SEARCH_COORDINATOR__
+#define _SEARCH_COORDINATOR__
+
+#include <deque>
+#include <string>
+#include <vector>
+
+class LineSocket;
+class SearchBudget;
+
+using namespace std;
+
+class SearchCoordinator {
+  /*
+   * SearchCoordinator hands the tasks of a partitioned search (see
+   * DepthFirstSearch::Partition) to SearchWorkers connecting over TCP, and
+   * collects their results. The first solution cancels the running tasks
+   * and no further tasks are handed out; tasks of workers that disconnect
+   * are handed to the next worker.
+   *
+   * Messages are lines of text. A worker starts with
+   *   HELLO CONFIG
+   * where CONFIG must equal the coordinator's, and then repeatedly sends
+   *   READY
+   * which the coordinator answers, once it has work, with
+   *   TASK ID PASS POSITION...
+   * or, once the search is over, with DONE. The worker answers a task with
+   *   RESULT ID STATUS NODES_EXPLORED NODES_PRUNED NUM_LINES
+   * followed by NUM_LINES lines of solution programs, where STATUS is
+   * solved, failed, cancelled or stopped:REASON if the worker's own budget
+   * ran out. While a task runs, the coordinator may send CANCEL.
+   */
+ public:
+  // Listens on port. budget is checked while waiting for results; not owned.
+  SearchCoordinator(int port, string config, SearchBudget *budget);
+  // Sends DONE to the connected workers.
+  ~SearchCoordinator();
+
+  // Runs the tasks, each a prefix of the search of the given pass, until
+  // all are done, one solves the problem or the search has to stop.
+  void Run(int pass, const vector<vector<int> > &tasks);
+
+  bool Solved() const;
+  const vector<string> &SolutionPrograms() const;
+  long NumNodesExplored() const;
+  long NumNodesPruned() const;
+  int NumWorkers() const;
+  // Why tasks were left unfinished, or "" if none were.
+  string Reason() const;
+
+ protected:
+  struct Worker {
+    LineSocket *socket;
+    bool ready;
+    // Index into tasks_ of the running task, or -1.
+    int task;
+  };
+
+  void Accept();
+  // Processes the lines received from a worker. Returns false if it
+  // disconnected or is rejected.
+  bool Receive(Worker &worker);
+  bool HandleLine(Worker &worker, const string &line);
+  void Stop(string reason);
+
+  string config_;
+  SearchBudget *budget_;
+  int listen_fd_;
+  vector<Worker> workers_;
+  int num_workers_seen_;
+
+  int pass_;
+  vector<vector<int> > tasks_;
+  deque<int> pending_;
+  int num_running_;
+  bool stopping_;
+
+  bool solved_;
+  vector<string> solution_programs_;
+  long num_nodes_explored_;
+  long num_nodes_pruned_;
+  string reason_;
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "search_options.h"
+#include "utils.h"
+
+
+SearchOptions::SearchOptions() :
+  max_secs(0), max_nodes(0), max_mem_mb(0),
+  top_k(1), heldout_examples(5), bidirectional(0), prune_ranges(false),
+  prune_feasibility(false), prune_unused(0),
+  prune_rewrites(false), prune_undefined(false), coordinator_port(0), prefix_length(1),
+  checkpoint_secs(60), resume(false), threads(0)
+{}
+
+
+bool SearchOptions::Parse(string arg) {
+  size_t eq = arg.find('=');
+  if (arg.compare(0, 2, "--") != 0 || eq == string::npos)  return false;
+
+  string name = arg.substr(2, eq - 2);
+  string value = arg.substr(eq + 1);
+
+  if (name == "stats") {
+    stats_filename = value;
+  } else if (name == "max_secs") {
+    max_secs = atof(value.c_str());
+  } else if (name == "max_nodes") {
+    max_nodes = atol(value.c_str());
+  } else if (name == "max_mem_mb") {
+    max_mem_mb = atol(value.c_str());
+  } else if (name == "top_k") {
+    top_k = atoi(value.c_str());
+  } else if (name == "heldout") {
+    heldout_test_set = value;
+  } else if (name == "heldout_examples") {
+    heldout_examples = atoi(value.c_str());
+  } else if (name == "library") {
+    library_filename = value;
+  } else if (name == "scorer") {
+    scorer_filename = value;
+  } else if (name == "bidirectional") {
+    bidirectional = atoi(value.c_str());
+  } else if (name == "prune_ranges") {
+    prune_ranges = atoi(value.c_str()) != 0;
+  } else if (name == "prune_feasibility") {
+    prune_feasibility = atoi(value.c_str()) != 0;
+  } else if (name == "prune_unused") {
+    prune_unused = atoi(value.c_str());
+    if (prune_unused < 0 || prune_unused > kPruneUnchained)  return false;
+  } else if (name == "prune_rewrites") {
+    prune_rewrites = atoi(value.c_str()) != 0;
+  } else if (name == "prune_undefined") {
+    prune_undefined = atoi(value.c_str()) != 0;
+  } else if (name == "cache") {
+    cache_dir = value;
+  } else if (name == "coordinator") {
+    coordinator_port = atoi(value.c_str());
+  } else if (name == "worker") {
+    worker_address = value;
+  } else if (name == "prefix_length") {
+    prefix_length = atoi(value.c_str());
+  } else if (name == "checkpoint") {
+    checkpoint_filename = value;
+  } else if (name == "checkpoint_secs") {
+    checkpoint_secs = atof(value.c_str());
+  } else if (name == "resume") {
+    resume = atoi(value.c_str()) != 0;
+  } else if (name == "serve") {
+    serve = value;
+  } else if (name == "threads") {
+    threads = atoi(value.c_str());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+
+string SearchOptions::Usage() {
+  return
+    "  --stats=FILE      JSON statistics output of INSTRUMENT_MODE builds\n"
+    "  --max_secs=S      stop the search after S seconds of wall time\n"
+    "  --max_nodes=N     stop the search after exploring N nodes\n"
+    "  --max_mem_mb=M    stop the search once the process uses M MB of memory\n"
+    "  --top_k=K         keep searching until K distinct solutions are found\n"
+    "  --heldout=NAME    with --top_k, tell solutions apart by their outputs on the\n"
+    "                    inputs of the same problem in data/NAME\n"
+    "  --heldout_examples=N  number of held-out examples per problem (default 5)\n"
+    "  --library=FILE    try the short programs of a program library first\n"
+    "  --scorer=FILE     order successors per node with the linear model in FILE\n"
+    "  --bidirectional=B first search MAX_PROG_LEN - B deep for intermediate results\n"
+    "                    that B inverted ops turn into the outputs\n"
+    "  --prune_ranges=1  skip prefixes whose value ranges cannot reach the targets\n"
+    "  --prune_feasibility=1  skip prefixes whose last one or two statements\n"
+    "                    cannot produce the targets\n"
+    "  --prune_unused=1  skip prefixes with more unread registers than the remaining\n"
+    "                    statements can read; =2 skip statements at the last depth\n"
+    "                    that do not read the register of the statement before\n"
+    "  --prune_rewrites=1  skip statements that are redundant with the one producing\n"
+    "                    their argument, e.g. sort of sort\n"
+    "  --prune_undefined=1  skip statements whose result is undefined in an example,\n"
+    "                    e.g. access out of range or arr_head of an empty array\n"
+    "  --cache=DIR       reuse and store search results in directory DIR\n"
+    "  --coordinator=PORT  hand parts of the search to workers connecting to PORT\n"
+    "  --worker=HOST:PORT  search parts handed out by the coordinator at HOST:PORT\n"
+    "  --prefix_length=K with --coordinator, split the search into the programs\n"
+    "                    starting with each K-statement prefix (default 1)\n"
+    "  --checkpoint=FILE save the state of the search to FILE periodically and when\n"
+    "                    it is stopped by its budget, SIGTERM or SIGINT\n"
+    "  --checkpoint_secs=S  seconds between checkpoints (default 60)\n"
+    "  --resume=1        with --checkpoint, continue from FILE if it exists\n"
+    "  --serve=stdin|PATH  answer search requests from stdin or a Unix socket\n"
+    "  --threads=N       with --serve, number of search threads (default: cores)\n";
+}
+
+
+string SearchOptions::Describe() const {
+  string result = "top_k " + to_string(top_k) + "\n";
+  if (!heldout_test_set.empty()) {
+    result += "heldout " + heldout_test_set + " " + to_string(heldout_examples) + "\n";
+  }
+  if (!scorer_filename.empty())  result += "scorer " + scorer_filename + "\n";
+  if (bidirectional > 0)  result += "bidirectional " + to_string(bidirectional) + "\n";
+  if (!library_filename.empty())  result += "library " + library_filename + "\n";
+  // Pruning only changes the node counts.
+  if (prune_ranges)  result += "prune_ranges 1\n";
+  if (prune_feasibility)  result += "prune_feasibility 1\n";
+  // Unlike the other pruning, they skip solutions that are not minimal.
+  if (prune_unused > 0)  result += "prune_unused " + to_string(prune_unused) + "\n";
+  if (prune_rewrites)  result += "prune_rewrites 1\n";
+  if (prune_undefined)  result += "prune_undefined 1\n";
+  return result;
+}
@@ -0,0 +1,99 @@
+#ifndef _SEARCH_OPTIONS__
+#define _SEARCH_OPTIONS__
+
+#include <string>
+
+using namespace std;
+
+struct SearchOptions {
+  /*
+   * Optional settings of a search. On the command line they follow the six
+   * positional arguments of `search`, each given as --name=value.
+   */
+  SearchOptions();
+
+  // Parses one --name=value argument. Returns false for unknown names.
+  bool Parse(string arg);
+  static string Usage();
+
+  // The options that can change the result of a search or the nodes it
+  // explores, as text. Part of the key of cached results, checkpoints and
+  // distributed searches.
+  string Describe() const;
+
+  // JSON file for the per-op/per-depth statistics of INSTRUMENT_MODE builds.
+  // Defaults to TEST_SET_PROB_IDX_ORDER_TYPE.stats.json.
+  string stats_filename;
+
+  // Per-problem limits; 0 means unlimited. The search stops with a report
+  // of its partial state once any of them is reached.
+  double max_secs;
+  long max_nodes;
+  long max_mem_mb;
+
+  // Number of distinct solutions to collect before stopping; each is printed
+  // as soon as it is found. With a held-out data set, solutions count as
+  // distinct only if they behave differently on its inputs.
+  int top_k;
+  string heldout_test_set;
+  int heldout_examples;
+
+  // Program library (see tools/build_library) checked before searching;
+  // none if empty.
+  string library_filename;
+
+  // Model file of a LinearScorer that orders the successors of every node;
+  // none if empty.
+  string scorer_filename;
+
+  // Number of statements to search backward from the outputs (see
+  // BackwardSubgoals); 0 disables bidirectional search.
+  int bidirectional;
+
+  // Skip subtrees that RangeAnalysis proves cannot reach the targets.
+  bool prune_ranges;
+  // Skip the last two levels of subtrees that fail FeasibilityCheck.
+  bool prune_feasibility;
+  // Skip programs that leave registers unread (see DepthFirstSearch): with
+  // kPruneNonMinimal, those with more unread registers than the remaining
+  // statements can read, which have no minimal completion; with
+  // kPruneUnchained, which ignores minimality, those whose statement at the
+  // last depth does not read the register of the statement before. 0
+  // disables it.
+  int prune_unused;
+  static const int kPruneNonMinimal = 1;
+  static const int kPruneUnchained = 2;
+  // Skip statements that the rewrite rules of RankedOpTable show to be
+  // redundant with the statement producing their argument.
+  bool prune_rewrites;
+  // Skip statements whose result is not defined (see Datum) in some
+  // example, such as access out of range or arr_head of an empty array.
+  bool prune_undefined;
+
+  // Directory of cached search results (see SearchCache); none if empty.
+  string cache_dir;
+
+  // Distributed search: a coordinator listening on coordinator_port splits
+  // the search into the prefixes of prefix_length statements and hands them
+  // to workers connecting to worker_address (HOST:PORT). Workers must be
+  // started with the same arguments and options as the coordinator.
+  int coordinator_port;
+  string worker_address;
+  int prefix_length;
+
+  // Save the state of the search to the file `checkpoint` every
+  // checkpoint_secs seconds and when it is stopped, and with resume,
+  // continue from the checkpoint in that file if there is one (see
+  // SearchCheckpoint).
+  string checkpoint_filename;
+  double checkpoint_secs;
+  bool resume;
+
+  // Server mode (see SolverServer): answer requests read from stdin if
+  // serve is "stdin", otherwise from a Unix domain socket at that path,
+  // with `threads` search threads (0 for one per core).
+  string serve;
+  int threads;
+};
+
+#endif
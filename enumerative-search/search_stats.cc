@@ -0,0 +1,146 @@
+#include "search_stats.h"
+#include "ranked_op_table.h"
+#include "utils.h"
+#include <fstream>
+#include <iomanip>
+#include <sys/time.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+static double WallSecs() {
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+static string JsonString(string s) {
+  string result = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\')  result += '\\';
+    result += c;
+  }
+  return result + "\"";
+}
+
+
+SearchStats::Counters::Counters() :
+  applied(0), sampled(0), sampled_cycles(0), pruned(0), goal_hits(0)
+{}
+
+
+SearchStats::SearchStats(const RankedOpTable *table, int max_program_length) :
+  table_(table),
+  max_program_length_(max_program_length),
+  counters_(max_program_length * table->NumOps()),
+  sample_counter_(0),
+  start_cycles_(ReadCycleCounter()),
+  start_secs_(WallSecs())
+{}
+
+
+SearchStats::Counters &SearchStats::At(int depth, int op_id) {
+  return counters_[depth * table_->NumOps() + op_id];
+}
+
+
+uint64_t SearchStats::ReadCycleCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+
+uint64_t SearchStats::BeginApply(int depth, int op_id) {
+  At(depth, op_id).applied++;
+  if (sample_counter_++ % kSamplePeriod != 0)  return 0;
+  return ReadCycleCounter();
+}
+
+
+void SearchStats::EndApply(int depth, int op_id, uint64_t start) {
+  if (start == 0)  return;
+  Counters &c = At(depth, op_id);
+  c.sampled++;
+  c.sampled_cycles += ReadCycleCounter() - start;
+}
+
+
+void SearchStats::RecordPruned(int depth, int op_id) {
+  At(depth, op_id).pruned++;
+}
+
+
+void SearchStats::RecordGoalHit(int depth, int op_id) {
+  At(depth, op_id).goal_hits++;
+}
+
+
+void SearchStats::WriteJson(string filename, string test_set, int problem_idx,
+                            int ordering_type, bool solved, int num_nodes_explored,
+                            double secs_taken) const {
+  double elapsed_secs = WallSecs() - start_secs_;
+  double cycles_per_sec = elapsed_secs > 0 ?
+    (ReadCycleCounter() - start_cycles_) / elapsed_secs : 1.0;
+
+  ofstream f;
+  f.open(filename);
+  CHECK(f.is_open(), "Failed to open file " + filename);
+  f << setprecision(9);
+
+  f << "{" << endl;
+  f << "  \"test_set\": " << JsonString(test_set) << "," << endl;
+  f << "  \"problem_idx\": " << problem_idx << "," << endl;
+  f << "  \"ordering_type\": " << ordering_type << "," << endl;
+  f << "  \"max_program_length\": " << max_program_length_ << "," << endl;
+  f << "  \"solved\": " << (solved ? "true" : "false") << "," << endl;
+  f << "  \"nodes_explored\": " << num_nodes_explored << "," << endl;
+  f << "  \"secs\": " << secs_taken << "," << endl;
+  f << "  \"cycles_per_sec\": " << cycles_per_sec << "," << endl;
+  f << "  \"sample_period\": " << kSamplePeriod << "," << endl;
+
+  // Per-depth totals over all ops.
+  f << "  \"depths\": [" << endl;
+  for (int depth = 0; depth < max_program_length_; depth++) {
+    Counters total;
+    for (int op_id = 0; op_id < table_->NumOps(); op_id++) {
+      const Counters &c = counters_[depth * table_->NumOps() + op_id];
+      total.applied += c.applied;
+      total.pruned += c.pruned;
+      total.goal_hits += c.goal_hits;
+    }
+    f << "    {\"depth\": " << depth << ", \"applied\": " << total.applied
+      << ", \"pruned\": " << total.pruned << ", \"goal_hits\": " << total.goal_hits << "}"
+      << (depth + 1 < max_program_length_ ? "," : "") << endl;
+  }
+  f << "  ]," << endl;
+
+  // Per-op counters, in the order the search tried the ops.
+  const vector<Successor> &ops = table_->Successors();
+  f << "  \"ops\": [" << endl;
+  for (int i = 0; i < ops.size(); i++) {
+    int op_id = ops[i].Id();
+    f << "    {\"name\": " << JsonString(ops[i].Name()) << ", \"rank\": " << i
+      << ", \"per_depth\": [" << endl;
+    for (int depth = 0; depth < max_program_length_; depth++) {
+      const Counters &c = counters_[depth * table_->NumOps() + op_id];
+      double kernel_secs = c.sampled > 0 ?
+        (double) c.sampled_cycles / c.sampled * c.applied / cycles_per_sec : 0.0;
+      f << "      {\"depth\": " << depth << ", \"applied\": " << c.applied
+        << ", \"sampled\": " << c.sampled << ", \"sampled_cycles\": " << c.sampled_cycles
+        << ", \"est_kernel_secs\": " << kernel_secs
+        << ", \"pruned\": " << c.pruned << ", \"goal_hits\": " << c.goal_hits << "}"
+        << (depth + 1 < max_program_length_ ? "," : "") << endl;
+    }
+    f << "    ]}" << (i + 1 < ops.size() ? "," : "") << endl;
+  }
+  f << "  ]" << endl;
+  f << "}" << endl;
+}
@@ -0,0 +1,74 @@
+#ifndef _SEARCH_STATS__
+#define _SEARCH_STATS__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "definitions.h"
+
+class RankedOpTable;
+
+using namespace std;
+
+// Hooks into the search hot loop are wrapped in INSTRUMENT(...), so that
+// they compile to nothing unless the search is built with
+//   make CFLAGS="-DINSTRUMENT_MODE"
+#ifdef INSTRUMENT_MODE
+#define INSTRUMENT(x) x
+#else
+#define INSTRUMENT(x)
+#endif
+
+
+class SearchStats {
+  /*
+   * SearchStats counts, for every op and every depth of the search, how
+   * often the op was applied, the time spent in its kernel, how many of its
+   * results were rejected by pruning and how many passed the goal test.
+   *
+   * Kernel time is measured with the cycle counter on one in kSamplePeriod
+   * applications and scaled up to an estimate of the total, which keeps
+   * the overhead of enabled instrumentation low.
+   */
+ public:
+  SearchStats(const RankedOpTable *table, int max_program_length);
+
+  // Counts an application and returns its start time, or 0 if this
+  // application is not sampled. Pass the result to EndApply.
+  uint64_t BeginApply(int depth, int op_id);
+  void EndApply(int depth, int op_id, uint64_t start);
+
+  void RecordPruned(int depth, int op_id);
+  void RecordGoalHit(int depth, int op_id);
+
+  void WriteJson(string filename, string test_set, int problem_idx, int ordering_type,
+                 bool solved, int num_nodes_explored, double secs_taken) const;
+
+  static const int kSamplePeriod = 16;
+
+ protected:
+  struct Counters {
+    Counters();
+
+    uint64_t applied;
+    uint64_t sampled;
+    uint64_t sampled_cycles;
+    uint64_t pruned;
+    uint64_t goal_hits;
+  };
+
+  Counters &At(int depth, int op_id);
+  static uint64_t ReadCycleCounter();
+
+  const RankedOpTable *table_;
+  int max_program_length_;
+  vector<Counters> counters_;
+  uint64_t sample_counter_;
+
+  // Used to convert cycles to seconds when writing the statistics.
+  uint64_t start_cycles_;
+  double start_secs_;
+};
+
+#endif
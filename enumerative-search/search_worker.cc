@@ -0,0 +1,108 @@
+#include "search_worker.h"
+#include "depth_first_search.h"
+#include "line_socket.h"
+#include "search_budget.h"
+#include "utils.h"
+#include <sstream>
+#include <unistd.h>
+
+
+// Connection attempts, 100ms apart, before giving up.
+static const int kConnectAttempts = 100;
+
+
+SearchWorker::SearchWorker(string address, string config) :
+  socket_(NULL),
+  num_tasks_(0)
+{
+  for (int i = 0; i < kConnectAttempts && socket_ == NULL; i++) {
+    if (i > 0)  usleep(100000);
+    socket_ = LineSocket::Connect(address);
+  }
+  CHECK_NOT_NULL(socket_, "Could not connect to coordinator " << address);
+  socket_->WriteLine("HELLO " + config);
+}
+
+
+SearchWorker::~SearchWorker() {
+  delete socket_;
+}
+
+
+void SearchWorker::Run(DepthFirstSearch *dfs, SearchBudget *budget,
+                       const vector<int> &search_lengths, bool first_pass_subgoals) {
+  budget->SetCancelCheck([this]() { return Cancelled(); });
+
+  string line;
+  while (socket_->WriteLine("READY") && ReadReply(line)) {
+    stringstream ss(line);
+    string command;
+    ss >> command;
+    if (command == "ERROR")  cerr << "Coordinator: " << line << endl;
+    if (command != "TASK")  break;
+
+    int task, pass;
+    ss >> task >> pass;
+    vector<int> start;
+    int position;
+    while (ss >> position)  start.push_back(position);
+    CHECK(pass >= 0 && pass < search_lengths.size() && !start.empty(),
+          "Malformed task: " << line);
+
+    long num_nodes_explored = dfs->NumNodesExplored();
+    long num_nodes_pruned = dfs->NumNodesPruned();
+    int num_solutions = dfs->SolutionPrograms().size();
+    dfs->Search(search_lengths[pass], start, first_pass_subgoals && pass == 0);
+    num_tasks_++;
+
+    string status = "failed";
+    vector<string> program_lines;
+    if (budget->Reason() == "cancelled") {
+      status = "cancelled";
+    } else if (!budget->Reason().empty()) {
+      status = "stopped:" + budget->Reason();
+    } else if (dfs->SolutionPrograms().size() > num_solutions) {
+      status = "solved";
+      stringstream program(dfs->SolutionPrograms().back());
+      string program_line;
+      while (getline(program, program_line))  program_lines.push_back(program_line);
+    }
+
+    socket_->WriteLine("RESULT " + to_string(task) + " " + status + " " +
+                       to_string(dfs->NumNodesExplored() - num_nodes_explored) + " " +
+                       to_string(dfs->NumNodesPruned() - num_nodes_pruned) + " " +
+                       to_string(program_lines.size()));
+    for (auto &program_line : program_lines)  socket_->WriteLine(program_line);
+    if (!budget->Reason().empty())  break;
+  }
+  budget->SetCancelCheck(function<bool()>());
+}
+
+
+bool SearchWorker::ReadReply(string &line) {
+  // A cancellation may arrive after its task ended.
+  do {
+    if (!socket_->ReadLine(line))  return false;
+  } while (line == "CANCEL");
+  return true;
+}
+
+
+bool SearchWorker::Cancelled() {
+  string line;
+  while (true) {
+    if (socket_->NextLine(line)) {
+      if (line == "CANCEL")  return true;
+    } else if (!socket_->Poll(0)) {
+      return false;
+    } else if (!socket_->Receive()) {
+      // The coordinator is gone.
+      return true;
+    }
+  }
+}
+
+
+int SearchWorker::NumTasks() const {
+  return num_tasks_;
+}
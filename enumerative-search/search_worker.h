@@ -0,0 +1,44 @@
+#ifndef _SEARCH_WORKER__
+#define _SEARCH_WORKER__
+
+#include <string>
+#include <vector>
+
+class DepthFirstSearch;
+class LineSocket;
+class SearchBudget;
+
+using namespace std;
+
+class SearchWorker {
+  /*
+   * SearchWorker connects to a SearchCoordinator and searches the tasks it
+   * is given with a DepthFirstSearch over the same problem, until the
+   * coordinator has none left. See search_coordinator.h for the protocol.
+   */
+ public:
+  // Connects to HOST:PORT, retrying for a while if nobody listens yet.
+  // CHECKs that it succeeds.
+  SearchWorker(string address, string config);
+  ~SearchWorker();
+
+  // Runs tasks with dfs. Pass i of the coordinator searches programs of up
+  // to search_lengths[i] statements; the first pass matches backward
+  // subgoals if first_pass_subgoals. budget is the one dfs checks; a task
+  // stopped by it ends the worker.
+  void Run(DepthFirstSearch *dfs, SearchBudget *budget, const vector<int> &search_lengths,
+           bool first_pass_subgoals);
+
+  int NumTasks() const;
+
+ protected:
+  // Reads the coordinator's next reply other than CANCEL.
+  bool ReadReply(string &line);
+  // Whether the coordinator cancelled the running task.
+  bool Cancelled();
+
+  LineSocket *socket_;
+  int num_tasks_;
+};
+
+#endif
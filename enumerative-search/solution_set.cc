@@ -0,0 +1,45 @@
+#include "solution_set.h"
+#include "datum.h"
+#include "io_set.h"
+#include "program_state.h"
+#include "successor.h"
+#include <sstream>
+
+
+SolutionSet::SolutionSet(int max_solutions, IOSet *heldout) :
+  max_solutions_(max_solutions),
+  heldout_(heldout),
+  size_(0)
+{}
+
+
+bool SolutionSet::Add(const vector<const Successor *> &program, int length) {
+  if (heldout_ != NULL) {
+    if (!behaviors_.insert(Behavior(program, length)).second)  return false;
+  }
+  size_++;
+  return true;
+}
+
+
+int SolutionSet::Size() const {
+  return size_;
+}
+
+
+bool SolutionSet::Full() const {
+  return size_ >= max_solutions_;
+}
+
+
+string SolutionSet::Behavior(const vector<const Successor *> &program, int length) {
+  for (int i = 0; i < length; i++)  ApplySuccessor(heldout_, program[i]);
+
+  stringstream ss;
+  for (int i = 0; i < heldout_->Size(); i++) {
+    ss << *heldout_->GetInputs(i)->GetLastDatum() << endl;
+  }
+
+  for (int i = 0; i < length; i++)  heldout_->Pop();
+  return ss.str();
+}
@@ -0,0 +1,43 @@
+#ifndef _SOLUTION_SET__
+#define _SOLUTION_SET__
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "definitions.h"
+
+class IOSet;
+class Successor;
+
+using namespace std;
+
+class SolutionSet {
+  /*
+   * SolutionSet collects up to max_solutions programs that solve a problem.
+   * Programs found by one search are always distinct as programs; if a
+   * held-out IOSet is given, a program is only counted if its outputs on
+   * the held-out inputs differ from those of every program collected so far.
+   */
+ public:
+  // heldout may be NULL and is not owned.
+  SolutionSet(int max_solutions, IOSet *heldout);
+
+  // Records the first `length` statements of program as a solution. Returns
+  // false if an equivalent solution was recorded before.
+  bool Add(const vector<const Successor *> &program, int length);
+
+  int Size() const;
+  bool Full() const;
+
+ protected:
+  // Outputs of the program on the held-out inputs, as a string.
+  string Behavior(const vector<const Successor *> &program, int length);
+
+  int max_solutions_;
+  IOSet *heldout_;
+  int size_;
+  unordered_set<string> behaviors_;
+};
+
+#endif
@@ -0,0 +1,348 @@
+#include "solver_server.h"
+#include "datum.h"
+#include "depth_first_search.h"
+#include "io_set.h"
+#include "line_index.h"
+#include "line_socket.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include "search_budget.h"
+#include "solution_set.h"
+#include "utils.h"
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// Longest program a request may ask for.
+static const int kMaxProgramLength = 10;
+
+
+// Whether a data file has at least num_lines lines.
+static bool HasLines(string filename, int num_lines) {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0)  return false;
+  LineIndex index(filename);
+  return index.LineOffset(num_lines - 1) < st.st_size;
+}
+
+
+SolverServer::Client::~Client() {
+  delete socket;
+}
+
+
+void SolverServer::Client::Send(const string &answer) {
+  lock_guard<mutex> guard(lock);
+  if (socket != NULL) {
+    socket->WriteLine(answer);
+  } else {
+    *out << answer << endl << flush;
+  }
+}
+
+
+SolverServer::SolverServer(const SearchOptions &defaults, int num_threads) :
+  defaults_(defaults),
+  num_in_flight_(0),
+  stopping_(false)
+{
+  defaults_.serve = "";
+  if (num_threads <= 0)  num_threads = max((int) thread::hardware_concurrency(), 1);
+  for (int i = 0; i < num_threads; i++)  threads_.push_back(thread(&SolverServer::WorkerLoop, this));
+}
+
+
+SolverServer::~SolverServer() {
+  {
+    unique_lock<mutex> lock(queue_lock_);
+    queue_changed_.wait(lock, [this]() { return num_in_flight_ == 0; });
+    stopping_ = true;
+  }
+  queue_changed_.notify_all();
+  for (auto &t : threads_)  t.join();
+}
+
+
+void SolverServer::Serve(istream &in, ostream &out) {
+  shared_ptr<Client> client(new Client());
+  client->out = &out;
+  client->socket = NULL;
+
+  while (true) {
+    Request *request = new Request();
+    if (!ReadRequest([&in](string &line) { return (bool) getline(in, line); }, *request)) {
+      delete request;
+      break;
+    }
+    request->client = client;
+    Enqueue(request);
+  }
+
+  unique_lock<mutex> lock(queue_lock_);
+  queue_changed_.wait(lock, [this]() { return num_in_flight_ == 0; });
+}
+
+
+void SolverServer::ServeSocket(string path) {
+  int listen_fd = LineSocket::ListenUnix(path);
+  cout << "Serving on " << path << endl;
+  while (true) {
+    LineSocket *socket = LineSocket::Accept(listen_fd);
+    if (socket != NULL)  thread(&SolverServer::ServeConnection, this, socket).detach();
+  }
+}
+
+
+void SolverServer::ServeConnection(LineSocket *socket) {
+  // The client closes the socket once the last answer is sent.
+  shared_ptr<Client> client(new Client());
+  client->out = NULL;
+  client->socket = socket;
+
+  while (true) {
+    Request *request = new Request();
+    if (!ReadRequest([socket](string &line) { return socket->ReadLine(line); }, *request)) {
+      delete request;
+      break;
+    }
+    request->client = client;
+    Enqueue(request);
+  }
+}
+
+
+bool SolverServer::ReadRequest(function<bool(string &)> next_line, Request &request) {
+  request.max_program_length = 0;
+  request.sort_and_add_cutoff = -1;
+  request.options = defaults_;
+  request.output_type = Int;
+  request.problem_idx = -1;
+  request.num_examples = 0;
+
+  string line, word;
+  do {
+    if (!next_line(line))  return false;
+  } while (line.find_first_not_of(" \t\r") == string::npos);
+
+  stringstream ss(line);
+  ss >> word;
+  if (word != "SOLVE") {
+    // Not a request block, answered on its own.
+    request.id = "-";
+    request.error = "expected SOLVE, got: " + line;
+    return true;
+  }
+  ParseLine(line, request);
+
+  while (next_line(line)) {
+    if (line == "END" || line == "END\r")  return true;
+    ParseLine(line, request);
+  }
+  if (request.error.empty())  request.error = "request ended without END";
+  return true;
+}
+
+
+void SolverServer::ParseLine(const string &line, Request &request) {
+  stringstream ss(line);
+  string word, error;
+  ss >> word;
+
+  if (word == "SOLVE") {
+    ss >> request.id >> request.max_program_length;
+    while (ss >> word) {
+      if (word.compare(0, 2, "--") == 0) {
+        if (!request.options.Parse(word))  error = "unknown option " + word;
+      } else {
+        request.sort_and_add_cutoff = atoi(word.c_str());
+      }
+    }
+    if (request.id.empty())  request.id = "-";
+
+  } else if (word == "TYPES" || word == "EXAMPLE") {
+    string rest;
+    getline(ss, rest);
+    size_t arrow = rest.find("->");
+    if (arrow == string::npos) {
+      error = "expected -> in " + word;
+    } else if (word == "TYPES") {
+      vector<DatumType> output_types;
+      if (!IOSet::ParseTypes(rest.substr(0, arrow), request.input_types) ||
+          !IOSet::ParseTypes(rest.substr(arrow + 2), output_types) ||
+          request.input_types.empty() || output_types.size() != 1) {
+        error = "malformed TYPES";
+      } else {
+        request.output_type = output_types[0];
+      }
+    } else {
+      request.inputs.push_back(rest.substr(0, arrow));
+      request.outputs.push_back(rest.substr(arrow + 2));
+    }
+
+  } else if (word == "ORDERING") {
+    double prob;
+    while (ss >> prob)  request.ordering.push_back(prob);
+    if (request.ordering.size() != RankedOpTable::ComponentNames().size()) {
+      error = "ORDERING needs " + to_string(RankedOpTable::ComponentNames().size()) +
+        " probabilities";
+    }
+
+  } else if (word == "PRIOR") {
+    ss >> request.prior;
+
+  } else if (word == "PROBLEM") {
+    ss >> request.test_set >> request.problem_idx >> request.num_examples;
+    if (ss.fail() || request.problem_idx < 0 || request.num_examples <= 0)  error = "malformed PROBLEM";
+
+  } else if (!word.empty()) {
+    error = "unexpected line: " + line;
+  }
+
+  if (request.error.empty())  request.error = error;
+}
+
+
+void SolverServer::Enqueue(Request *request) {
+  {
+    lock_guard<mutex> lock(queue_lock_);
+    queue_.push_back(request);
+    num_in_flight_++;
+  }
+  queue_changed_.notify_all();
+}
+
+
+void SolverServer::WorkerLoop() {
+  while (true) {
+    Request *request;
+    {
+      unique_lock<mutex> lock(queue_lock_);
+      queue_changed_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+      if (queue_.empty())  return;
+      request = queue_.front();
+      queue_.pop_front();
+    }
+
+    request->client->Send(Solve(*request));
+    delete request;
+
+    {
+      lock_guard<mutex> lock(queue_lock_);
+      num_in_flight_--;
+    }
+    queue_changed_.notify_all();
+  }
+}
+
+
+string SolverServer::Solve(const Request &request) {
+  MyTimer timer;
+  timer.tic();
+
+  // Everything that would make the search CHECK-fail is answered with an
+  // error instead, so that a bad request cannot take down the server.
+  const SearchOptions &options = request.options;
+  string error = request.error;
+  if (error.empty() &&
+      (request.max_program_length < 1 || request.max_program_length > kMaxProgramLength)) {
+    error = "MAX_PROG_LEN must be between 1 and " + to_string(kMaxProgramLength);
+  }
+  if (error.empty() &&
+      (options.bidirectional > 0 || !options.library_filename.empty() || !options.cache_dir.empty() ||
+       !options.heldout_test_set.empty() || options.coordinator_port > 0 ||
+       !options.worker_address.empty() || !options.serve.empty() ||
+       !options.checkpoint_filename.empty() || !options.stats_filename.empty())) {
+    error = "only budget, --top_k, --scorer and pruning options are supported";
+  }
+  if (error.empty() && options.max_mem_mb > 0) {
+    error = "--max_mem_mb is not supported, as memory is only measured for the whole process";
+  }
+  if (error.empty() && !options.scorer_filename.empty() &&
+      access(options.scorer_filename.c_str(), R_OK) != 0) {
+    error = "cannot read " + options.scorer_filename;
+  }
+
+  string prior = request.prior.empty() ? request.test_set : request.prior;
+  string prior_filename = "data/" + prior + "/prior.txt";
+  if (error.empty() && request.ordering.empty() &&
+      (prior.empty() || access(prior_filename.c_str(), R_OK) != 0)) {
+    error = "no ORDERING and no prior at " + prior_filename;
+  }
+
+  IOSet *io = NULL;
+  if (error.empty() && !request.test_set.empty()) {
+    string dir = "data/" + request.test_set + "/";
+    int num_lines = (request.problem_idx + 1) * request.num_examples;
+    if (!HasLines(dir + "input_types.txt", request.problem_idx + 1) ||
+        !HasLines(dir + "output_types.txt", request.problem_idx + 1) ||
+        !HasLines(dir + "input_values.txt", num_lines) ||
+        !HasLines(dir + "output_values.txt", num_lines)) {
+      error = "no problem " + to_string(request.problem_idx) + " with " +
+        to_string(request.num_examples) + " examples in " + dir;
+    } else {
+      io = new IOSet(dir, request.problem_idx, request.num_examples);
+    }
+  } else if (error.empty()) {
+    vector<DatumType> output_types(1, request.output_type);
+    vector<ProgramState *> inputs;
+    vector<Datum *> outputs;
+    for (int i = 0; i < request.inputs.size() && error.empty(); i++) {
+      ProgramState *input = IOSet::ParseValues(request.inputs[i], request.input_types);
+      ProgramState *output = IOSet::ParseValues(request.outputs[i], output_types);
+      if (input == NULL || output == NULL) {
+        error = "EXAMPLE " + to_string(i + 1) + " does not match the TYPES";
+        delete input;
+        delete output;
+      } else {
+        inputs.push_back(input);
+        outputs.push_back(new Datum(*output->GetDatum(0)));
+        delete output;
+      }
+    }
+    if (error.empty() && inputs.empty())  error = "no EXAMPLE";
+    if (error.empty()) {
+      io = new IOSet(inputs, outputs);
+    } else {
+      for (auto input : inputs)  delete input;
+      for (auto output : outputs)  delete output;
+    }
+  }
+
+  if (!error.empty()) {
+    return "RESULT " + request.id + " error:" + error + "\nEND";
+  }
+
+  RankedOpTable *own_table = NULL;
+  const RankedOpTable *table;
+  if (!request.ordering.empty()) {
+    own_table = new RankedOpTable(request.ordering, request.sort_and_add_cutoff);
+    table = own_table;
+  } else {
+    table = RankedOpTable::Shared(prior_filename, request.sort_and_add_cutoff);
+  }
+
+  SearchBudget budget(options);
+  budget.Start();
+  SolutionSet solutions(max(options.top_k, 1), NULL);
+  // No SearchStats is attached: one shared by the threads would race, and
+  // requests have nowhere to write their own.
+  DepthFirstSearch *dfs = new DepthFirstSearch(table, io, request.max_program_length, options,
+                                               &budget, &solutions, NULL);
+  dfs->Search(request.max_program_length, vector<int>(), false);
+
+  double secs_taken;
+  timer.toc(false, NULL, &secs_taken);
+  string status = dfs->Solved() ? "solved" : "failed";
+  if (!budget.Reason().empty())  status = "stopped:" + budget.Reason();
+  stringstream answer;
+  answer << "RESULT " << request.id << " " << status << " " << dfs->NumNodesExplored() << " "
+         << secs_taken << endl;
+  for (auto &program : dfs->SolutionPrograms())  answer << "SOLUTION" << endl << program;
+  answer << "END";
+
+  delete dfs;
+  delete io;
+  delete own_table;
+  return answer.str();
+}
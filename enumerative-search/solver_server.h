@@ -0,0 +1,126 @@
+#ifndef _SOLVER_SERVER__
+#define _SOLVER_SERVER__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "definitions.h"
+#include "search_options.h"
+
+class LineSocket;
+
+using namespace std;
+
+class SolverServer {
+  /*
+   * SolverServer answers search requests read from a stream or from the
+   * connections to a Unix domain socket, so that a pipeline does not pay
+   * for starting `search` and loading its tables for every problem. Op
+   * tables of dataset-wide orderings stay loaded (see RankedOpTable::Shared)
+   * as do the line indexes of data files. Requests are searched by a pool
+   * of threads, each under its own budget, and answered as they finish, so
+   * answers can come out of order.
+   *
+   * A request is a block of lines
+   *   SOLVE ID MAX_PROG_LEN [SaA_CUTOFF] [--name=value ...]
+   *   TYPES Int Array -> Int
+   *   EXAMPLE 8 | 7 9 3 1 3 0 7 2 3 1 -> 7
+   *   ...
+   *   ORDERING P_1 ... P_n
+   *   END
+   * where the values are in the format of the data files, and the ORDERING
+   * holds a probability per component in RankedOpTable::ComponentNames()
+   * order. Instead of an ORDERING, "PRIOR NAME" ranks the ops by
+   * data/NAME/prior.txt. Instead of TYPES and EXAMPLE lines,
+   * "PROBLEM NAME PROB_IDX NUM_EXAMPLES" loads a problem of data/NAME,
+   * whose prior is then the default ordering. The answer is
+   *   RESULT ID STATUS NODES_EXPLORED SECS
+   *   SOLUTION
+   *    %2 <- sort %1
+   *   ...
+   *   END
+   * with a SOLUTION block per solution found and STATUS one of solved,
+   * failed, stopped:REASON if the budget ran out, or error:MESSAGE.
+   *
+   * Requests cannot set --stats, and INSTRUMENT_MODE builds count nothing
+   * for them. Budgets are --max_secs and --max_nodes. --max_mem_mb is answered with
+   * an error: SearchBudget reads the peak memory of the whole process,
+   * which the requests share and which never goes down, so one large
+   * request would stop every later one.
+   */
+ public:
+  // defaults holds the options of requests that do not set them. Starts
+  // num_threads search threads, or one per core if it is 0.
+  SolverServer(const SearchOptions &defaults, int num_threads);
+  // Waits for the requests received so far.
+  ~SolverServer();
+
+  // Answers the requests read from in on out, until in ends and all of
+  // them are answered.
+  void Serve(istream &in, ostream &out);
+  // Answers requests on every connection to a Unix domain socket at path.
+  // Does not return.
+  void ServeSocket(string path);
+
+ protected:
+  // Where answers to the requests of one stream or connection go.
+  struct Client {
+    mutex lock;
+    ostream *out;
+    LineSocket *socket;
+    ~Client();
+    void Send(const string &answer);
+  };
+
+  struct Request {
+    string id;
+    int max_program_length;
+    int sort_and_add_cutoff;
+    SearchOptions options;
+    // Inline examples.
+    vector<DatumType> input_types;
+    DatumType output_type;
+    vector<string> inputs;
+    vector<string> outputs;
+    // Or a problem of a data set.
+    string test_set;
+    int problem_idx;
+    int num_examples;
+    // Op ranking.
+    vector<double> ordering;
+    string prior;
+    // Why the request cannot be searched, or "".
+    string error;
+    shared_ptr<Client> client;
+  };
+
+  // Reads a request block with next_line, starting at its SOLVE line.
+  // Returns false once there are no more lines.
+  bool ReadRequest(function<bool(string &)> next_line, Request &request);
+  void ParseLine(const string &line, Request &request);
+  // Reads requests from a connection and queues them.
+  void ServeConnection(LineSocket *socket);
+
+  void Enqueue(Request *request);
+  void WorkerLoop();
+  string Solve(const Request &request);
+
+  SearchOptions defaults_;
+  vector<thread> threads_;
+
+  mutex queue_lock_;
+  condition_variable queue_changed_;
+  deque<Request *> queue_;
+  int num_in_flight_;
+  bool stopping_;
+};
+
+#endif
@@ -1,20 +1,15 @@
 #include "successor.h"
 #include "io_set.h"
+#include "node_scorer.h"
 #include "program_state.h"
-#include "ops.h"
+#include "ranked_op_table.h"
 #include "utils.h"
+#include <algorithm>
 #include <iostream>
-#include <fstream>
 #include <sstream>
-#include <map>
 #include <utility>
 
 
-bool SuccPairCompare(pair<double, Successor> a, pair<double, Successor> b) {
-  return (a.first > b.first);
-}
-
-
 ostream &operator<<(ostream &os, const Successor &s) {
   if (s.IsOp1()) {
     os << "op1_" << s.op1_ << "(" << s.op1_arg_ << ")";
@@ -25,33 +20,60 @@ ostream &operator<<(ostream &os, const Successor &s) {
 }
 
 
-SuccessorIterator::SuccessorIterator() {
-  InitOps();
-  InitSuccessors();
+void ApplySuccessor(IOSet *io, const Successor *successor) {
+  if (successor->IsOp1()) {
+    io->ApplyOp1(successor->GetOp1(), successor->GetOp1Arg());
+  } else if (successor->IsOp2()) {
+    io->ApplyOp2(successor->GetOp2(), successor->GetOp2Arg1(),
+                 successor->GetOp2Arg2());
+  }
 }
 
 
-SuccessorIterator::SuccessorIterator(IOSet *io) {
-  InitOps();
-  InitSuccessors();
-  Init(io);
-  /*
-  for (auto &succ: successors_) {
-    cout << succ.Name() << endl;
+bool Solves(IOSet *io, const vector<Successor> &statements) {
+  for (auto &statement : statements)  ApplySuccessor(io, &statement);
+  bool solved = io->IsSolved();
+  for (int i = 0; i < statements.size(); i++)  io->Pop();
+  return solved;
+}
+
+
+string FormatProgram(const vector<const Successor *> &program, int length, int num_inputs) {
+  stringstream ss;
+  for (int i = 0; i < length; ++i) {
+    const Successor *successor = program[i];
+    ss << " %" << i + num_inputs << " <- " << successor->Name();
+    if (successor->IsOp1()) {
+      ss << " %" << successor->GetOp1Arg();
+    } else {
+      ss << " %" << successor->GetOp2Arg1() << " %" << successor->GetOp2Arg2();
+    }
+    ss << endl;
   }
-  */
+  return ss.str();
 }
 
 
-SuccessorIterator::SuccessorIterator(string order_filename, IOSet *io, int sort_and_add_cutoff) {
-  InitOps();
-  InitSuccessors(order_filename, sort_and_add_cutoff);
+SuccessorIterator::SuccessorIterator(const RankedOpTable *table, IOSet *io) :
+  table_(table),
+  successors_(table->Successors()),
+  prefix_(NULL),
+  last_depth_(false),
+  scorer_(NULL)
+{
   Init(io);
-  /*
-  for (auto &succ: successors_) {
-    cout << succ.Name() << endl;
-  }
-  */
+}
+
+
+void SuccessorIterator::SetPrefix(const vector<const Successor *> *prefix, bool last_depth) {
+  prefix_ = prefix;
+  last_depth_ = last_depth;
+}
+
+
+void SuccessorIterator::SetScorer(NodeScorer *scorer) {
+  scorer_ = scorer;
+  order_.clear();
 }
 
 
@@ -67,11 +89,37 @@ SuccessorIterator::~SuccessorIterator() {}
  */
 void SuccessorIterator::Init(IOSet *io) {
   auto ps = io->GetInputs(0);
+  num_inputs_ = ps->NumInputs();
   types_.clear();
+  arg_order_.clear();
   for (int i = 0; i < ps->NumUsed(); i++) {
     types_.push_back(ps->GetDatumType(i));
+    arg_order_.push_back(i);
   }
   counter_ = 0;
+  if (prefix_ != NULL) {
+    producer_ids_.assign(num_inputs_, -1);
+    for (int i = num_inputs_; i < types_.size(); i++) {
+      producer_ids_.push_back((*prefix_)[i - num_inputs_]->Id());
+    }
+  }
+
+  if (order_.size() != successors_.size() || scorer_ != NULL) {
+    order_.resize(successors_.size());
+    for (int i = 0; i < order_.size(); i++)  order_[i] = i;
+  }
+  if (scorer_ != NULL) {
+    register_scores_.clear();
+    scorer_->Score(io, op_scores_, register_scores_);
+    stable_sort(order_.begin(), order_.end(), [this](int a, int b) {
+        return op_scores_[successors_[a].Id()] > op_scores_[successors_[b].Id()];
+      });
+    if (!register_scores_.empty()) {
+      stable_sort(arg_order_.begin(), arg_order_.end(), [this](int a, int b) {
+          return register_scores_[a] > register_scores_[b];
+        });
+    }
+  }
 
   if (cumulative_counts_.size() == 0) {
     cumulative_counts_.resize(successors_.size(), -1);
@@ -81,6 +129,33 @@ void SuccessorIterator::Init(IOSet *io) {
 }
 
 
+inline bool SuccessorIterator::Redundant(const Successor &op, int arg1, int arg2) const {
+  if (op.IsOp2()) {
+    if (table_->Commutative(op.Id()) && arg1 > arg2)  return true;
+    // f(x, x) is x; an input is kept, as it cannot be the output otherwise.
+    if (table_->IdempotentOnPairs(op.Id()) && arg1 == arg2 && arg1 >= num_inputs_)  return true;
+  }
+
+  // The rules are about the array argument.
+  int arg = op.IsOp1() ? arg1 : arg2;
+  if (arg < num_inputs_)  return false;
+  const Successor *producer = (*prefix_)[arg - num_inputs_];
+  switch (table_->GetRewrite(op.Id(), producer_ids_[arg])) {
+    case RankedOpTable::kRedundant:
+      return true;
+    case RankedOpTable::kCancels:
+      // Likewise, f(g(x)) is kept for an input x.
+      return producer->GetOp1Arg() >= num_inputs_;
+    case RankedOpTable::kSameCount:
+      return producer->GetOp2Arg1() == arg1;
+    case RankedOpTable::kCommutes:
+      return last_depth_ && arg == types_.size() - 1;
+    default:
+      return false;
+  }
+}
+
+
 /*
  * Strategy: first iterate over all ops, then iterate over
  * all compatible inputs.
@@ -95,11 +170,14 @@ const Successor *SuccessorIterator::Cur() {
       continue;
     }
 
-    Successor &succ = successors_[i];
+    Successor &succ = successors_[order_[i]];
+    bool prune = prefix_ != NULL && table_->HasRules(succ.Id());
     if (succ.IsOp1()) {
       // iterate over single arguments of the right type
-      for (int j = 0; j < types_.size(); j++) {
+      for (int jj = 0; jj < types_.size(); jj++) {
+        int j = arg_order_[jj];
         if (types_[j] != succ.GetOp1ArgType())  continue;
+        if (prune && Redundant(succ, j, -1))  continue;
 
         if (counter >= counter_) {
           succ.SetOp1Arg(j);
@@ -111,12 +189,14 @@ const Successor *SuccessorIterator::Cur() {
 
     } else if (succ.IsOp2()) {
       // iterate over pairs of arguments of the right type
-      for (int j1 = 0; j1 < types_.size(); j1++) {
-        for (int j2 = 0; j2 < types_.size(); j2++) {
+      for (int jj1 = 0; jj1 < types_.size(); jj1++) {
+        for (int jj2 = 0; jj2 < types_.size(); jj2++) {
+          int j1 = arg_order_[jj1], j2 = arg_order_[jj2];
           if (types_[j1] != succ.GetOp2Arg1Type() ||
               types_[j2] != succ.GetOp2Arg2Type()) {
             continue;
           }
+          if (prune && Redundant(succ, j1, j2))  continue;
 
           if (counter >= counter_) {
             succ.SetOp2Args(j1, j2);
@@ -139,236 +219,13 @@ const Successor *SuccessorIterator::Next() {
 }
 
 
-void SuccessorIterator::InitOps() {
-  // int to int ops
-  if (false) {  // Matej doesn't use these
-    int_to_int_ops_.push_back(make_pair("increment", increment));
-    int_to_int_ops_.push_back(make_pair("decrement", decrement));
-  }
-
-  // int[] to int ops
-  if (true) {  // element selection
-    arr_to_int_ops_.push_back(make_pair("arr_min", arr_min));
-    arr_to_int_ops_.push_back(make_pair("arr_max", arr_max));
-    arr_to_int_ops_.push_back(make_pair("arr_head", arr_head));
-    arr_to_int_ops_.push_back(make_pair("arr_last", arr_last));
-    arr_to_int_ops_.push_back(make_pair("arr_sum", arr_sum));
-  }
-
-  if (true) {  // counting
-    arr_to_int_ops_.push_back(make_pair("count_is_pos", count_is_pos));
-    arr_to_int_ops_.push_back(make_pair("count_is_neg", count_is_neg));
-    arr_to_int_ops_.push_back(make_pair("count_is_even", count_is_even));
-    arr_to_int_ops_.push_back(make_pair("count_is_odd", count_is_odd));
-  }
-
-  // int[] to int[] ops
-  if (true) {  // maps
-    arr_to_arr_ops_.push_back(make_pair("map_increment", map_increment));
-    arr_to_arr_ops_.push_back(make_pair("map_decrement", map_decrement));
-    arr_to_arr_ops_.push_back(make_pair("map_mult2", map_mult2));
-    arr_to_arr_ops_.push_back(make_pair("map_div2", map_div2));
-    arr_to_arr_ops_.push_back(make_pair("map_negate", map_negate));
-    arr_to_arr_ops_.push_back(make_pair("map_sqr", map_sqr));
-    arr_to_arr_ops_.push_back(make_pair("map_mult3", map_mult3));
-    arr_to_arr_ops_.push_back(make_pair("map_div3", map_div3));
-    arr_to_arr_ops_.push_back(make_pair("map_mult4", map_mult4));
-    arr_to_arr_ops_.push_back(make_pair("map_div4", map_div4));
-  }
-
-  if (true) {  // filters
-    arr_to_arr_ops_.push_back(make_pair("filter_is_pos", filter_is_pos));
-    arr_to_arr_ops_.push_back(make_pair("filter_is_neg", filter_is_neg));
-    arr_to_arr_ops_.push_back(make_pair("filter_is_odd", filter_is_odd));
-    arr_to_arr_ops_.push_back(make_pair("filter_is_even", filter_is_even));
-  }
-
-  if (true) {  // sort and reverse
-    arr_to_arr_ops_.push_back(make_pair("sort", sort_datum));
-    arr_to_arr_ops_.push_back(make_pair("reverse", reverse_datum));
-  }
-
-  if (true) {  // scanl
-    arr_to_arr_ops_.push_back(make_pair("scanl_add", scanl_add));
-    arr_to_arr_ops_.push_back(make_pair("scanl_subtract", scanl_subtract));
-    arr_to_arr_ops_.push_back(make_pair("scanl_mult", scanl_mult));
-    arr_to_arr_ops_.push_back(make_pair("scanl_max", scanl_max));
-    arr_to_arr_ops_.push_back(make_pair("scanl_min", scanl_min));
-  }
-
-  if (true) {
-    int_arr_to_int_ops_.push_back(make_pair("access", access));
-  }
-  // int[] x int[] to int[] ops
-  if (true) {
-    int_arr_to_arr_ops_.push_back(make_pair("take", take));
-    int_arr_to_arr_ops_.push_back(make_pair("drop", drop));
-  }
-
-  // int[] x int[] to int[] ops
-  if (true) {
-    arr_arr_to_arr_ops_.push_back(make_pair("zipwith_add", zipwith_add));
-    arr_arr_to_arr_ops_.push_back(make_pair("zipwith_subtract", zipwith_subtract));
-    arr_arr_to_arr_ops_.push_back(make_pair("zipwith_mult", zipwith_mult));
-    arr_arr_to_arr_ops_.push_back(make_pair("zipwith_max", zipwith_max));
-    arr_arr_to_arr_ops_.push_back(make_pair("zipwith_min", zipwith_min));
-  }
-}
-
-
-void SuccessorIterator::InitSuccessors() {
-  // Lots of copy construction here is ok, since Successor
-  // is essentially a light-weight struct.
-  for (auto &op : int_to_int_ops_) {
-    Successor next_succ(op.first, op.second, Int);
-    successors_.push_back(next_succ);
-  }
-  for (auto &op : arr_to_int_ops_) {
-    Successor next_succ(op.first, op.second, Array);
-    successors_.push_back(next_succ);
-  }
-  for (auto &op : arr_to_arr_ops_) {
-    Successor next_succ(op.first, op.second, Array);
-    successors_.push_back(next_succ);
-  }
-  for (auto &op : int_arr_to_int_ops_) {
-    Successor next_succ(op.first, op.second, Int, Array);
-    successors_.push_back(next_succ);
-  }
-  for (auto &op : int_arr_to_arr_ops_) {
-    Successor next_succ(op.first, op.second, Int, Array);
-    successors_.push_back(next_succ);
-  }
-  for (auto &op : arr_arr_to_arr_ops_) {
-    Successor next_succ(op.first, op.second, Array, Array);
-    successors_.push_back(next_succ);
-  }
-
-
+int SuccessorIterator::Position() const {
+  return counter_;
 }
 
 
-void SuccessorIterator::InitSuccessors(string order_filename, int sort_and_add_cutoff) {
-  InitSuccessors();
-
-  // TODO: move this somewhere more sensible
-  string ZIPWITH = "ZIPWITH";
-  string TIMES = "*";
-  string MAP = "MAP";
-  string SQR = "SQR";
-  string MUL4 = "MUL4";
-  string DIV4 = "DIV4";
-  string MINUS = "-";
-  string MUL3 = "MUL3";
-  string DIV3 = "DIV3";
-  string MIN = "MIN";
-  string PLUS = "+";
-  string SCANL = "SCANL";
-  string SHR = "SHR";
-  string SHL = "SHL";
-  string MAX = "MAX";
-  string HEAD = "HEAD";
-  string DEC = "DEC";
-  string SUM = "SUM";
-  string doNEG = "doNEG";
-  string isNEG = "isNEG";
-  string INC = "INC";
-  string LAST = "LAST";
-  string MINIMUM = "MINIMUM";
-  string isPOS = "isPOS";
-  string SORT = "SORT";
-  string FILTER = "FILTER";
-  string isODD = "isODD";
-  string REVERSE = "REVERSE";
-  string ACCESS = "ACCESS";
-  string isEVEN = "isEVEN";
-  string COUNT = "COUNT";
-  string TAKE = "TAKE";
-  string MAXIMUM = "MAXIMUM";
-  string DROP = "DROP";
-
-  map<string, vector<string> > components;
-  components["arr_min"] = vector<string>({MINIMUM});
-  components["arr_max"] = vector<string>({MAXIMUM});
-  components["arr_head"] = vector<string>({HEAD});
-  components["arr_last"] = vector<string>({LAST});
-  components["arr_sum"] = vector<string>({MAP, SUM});
-
-  components["count_is_pos"] = vector<string>({COUNT, isPOS});
-  components["count_is_neg"] = vector<string>({COUNT, isNEG});
-  components["count_is_even"] = vector<string>({COUNT, isEVEN});
-  components["count_is_odd"] = vector<string>({COUNT, isODD});
-
-  components["filter_is_pos"] = vector<string>({FILTER, isPOS});
-  components["filter_is_neg"] = vector<string>({FILTER, isNEG});
-  components["filter_is_even"] = vector<string>({FILTER, isEVEN});
-  components["filter_is_odd"] = vector<string>({FILTER, isODD});
-
-  components["map_increment"] = vector<string>({MAP, INC});
-  components["map_decrement"] = vector<string>({MAP, INC});
-  components["map_mult2"] = vector<string>({MAP, SHL});
-  components["map_div2"] = vector<string>({MAP, SHR});
-  components["map_negate"] = vector<string>({MAP, doNEG});
-  components["map_sqr"] = vector<string>({MAP, SQR});
-  components["map_mult3"] = vector<string>({MAP, MUL3});
-  components["map_div3"] = vector<string>({MAP, DIV3});
-  components["map_mult4"] = vector<string>({MAP, MUL4});
-  components["map_div4"] = vector<string>({MAP, DIV4});
-
-  components["sort"] = vector<string>({SORT});
-  components["reverse"] = vector<string>({REVERSE});
-
-  components["take"] = vector<string>({TAKE});
-  components["drop"] = vector<string>({DROP});
-  components["access"] = vector<string>({ACCESS});
-
-
-  components["scanl_add"] = vector<string>({SCANL, PLUS});
-  components["scanl_subtract"] = vector<string>({SCANL, MINUS});
-  components["scanl_mult"] = vector<string>({SCANL, TIMES});
-  components["scanl_max"] = vector<string>({SCANL, MAX});
-  components["scanl_min"] = vector<string>({SCANL, MIN});
-
-  components["zipwith_add"] = vector<string>({ZIPWITH, PLUS});
-  components["zipwith_subtract"] = vector<string>({ZIPWITH, MINUS});
-  components["zipwith_mult"] = vector<string>({ZIPWITH, TIMES});
-  components["zipwith_max"] = vector<string>({ZIPWITH, MAX});
-  components["zipwith_min"] = vector<string>({ZIPWITH, MIN});
-
-
-  ifstream f;
-  f.open(order_filename);
-  CHECK(f.is_open(), "Failed to open file " + order_filename);
-
-  map<string, double> name_to_prob;
-
-  double prob;
-  string name;
-  while (f >> prob) {
-    f >> name;
-    name_to_prob.insert(make_pair(name, prob));
-  }
-
-  vector<pair<double, Successor> > weighted_successors;
-  for (auto &succ : successors_) {
-    double prob = 1.0;
-    for (auto &component : components[succ.Name()]) {
-      prob = min(prob, name_to_prob[component]);
-    }
-    //if (prob >= 0)
-    weighted_successors.push_back(make_pair(prob, succ));
-  }
-  successors_.clear();
-
-  sort(weighted_successors.begin(), weighted_successors.end(), SuccPairCompare);
-
-  int ii = 0;
-  for (auto &p : weighted_successors) {
-    //cout << p.first << " " << p.second.Name() << endl;
-    if ((sort_and_add_cutoff == -1) || (ii < sort_and_add_cutoff))
-      successors_.push_back(p.second);
-    ii++;
-  }
+void SuccessorIterator::Seek(int position) {
+  counter_ = position;
 }
 
 
@@ -378,45 +235,45 @@ void SuccessorIterator::InitSuccessors(string order_filename, int sort_and_add_c
  *
  **/
 
-Successor::Successor() {
-
-}
+Successor::Successor() :
+  id_(-1)
+{}
 
 
-Successor::Successor(DatumOp1 op, DatumType arg1_type) {
+Successor::Successor(string name, DatumOp1 op, DatumType arg1_type, DatumType result_type) {
+  id_ = -1;
   op_type_ = Op1;
   op1_ = op;
   op1_arg_type_ = arg1_type;
+  name_ = name;
+  result_type_ = result_type;
 }
 
 
-Successor::Successor(DatumOp2 op, DatumType arg1_type, DatumType arg2_type) {
+Successor::Successor(string name, DatumOp2 op, DatumType arg1_type, DatumType arg2_type,
+                     DatumType result_type) {
+  id_ = -1;
   op_type_ = Op2;
   op2_ = op;
   op2_arg1_type_ = arg1_type;
   op2_arg2_type_ = arg2_type;
+  name_ = name;
+  result_type_ = result_type;
 }
 
 
-Successor::Successor(string name, DatumOp1 op, DatumType arg1_type) {
-  op_type_ = Op1;
-  op1_ = op;
-  op1_arg_type_ = arg1_type;
-  name_ = name;
+string Successor::Name() const {
+  return name_;
 }
 
 
-Successor::Successor(string name, DatumOp2 op, DatumType arg1_type, DatumType arg2_type) {
-  op_type_ = Op2;
-  op2_ = op;
-  op2_arg1_type_ = arg1_type;
-  op2_arg2_type_ = arg2_type;
-  name_ = name;
+int Successor::Id() const {
+  return id_;
 }
 
 
-string Successor::Name() const {
-  return name_;
+DatumType Successor::ResultType() const {
+  return result_type_;
 }
 
 
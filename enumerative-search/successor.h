@@ -10,7 +10,9 @@
 
 
 class IOSet;
+class NodeScorer;
 class ProgramState;
+class RankedOpTable;
 class SuccessorIterator;
 
 enum OpType {Op1, Op2};
@@ -23,15 +25,18 @@ class Successor {
    */
 
   friend class SuccessorIterator;
+  friend class RankedOpTable;
 
  public:
   Successor();
-  Successor(DatumOp1 op, DatumType arg1_type);
-  Successor(DatumOp2 op, DatumType arg1_type, DatumType arg2_type);
-  Successor(string name, DatumOp1 op, DatumType arg1_type);
-  Successor(string name, DatumOp2 op, DatumType arg1_type, DatumType arg2_type);
+  Successor(string name, DatumOp1 op, DatumType arg1_type, DatumType result_type);
+  Successor(string name, DatumOp2 op, DatumType arg1_type, DatumType arg2_type,
+            DatumType result_type);
 
   string Name() const;
+  // Index of the op in RankedOpTable::Op(), or -1 if not from a table.
+  int Id() const;
+  DatumType ResultType() const;
   bool IsOp1() const;
   DatumOp1 GetOp1() const;
   int GetOp1Arg() const;
@@ -60,50 +65,80 @@ class Successor {
   DatumType op2_arg2_type_;
 
   string name_;
+  int id_;
+  DatumType result_type_;
   double weight_;
 
   friend ostream &operator<<(ostream &os, const Successor &s);
 };
 
 
+// Applies the op of a successor to every example of an IOSet.
+void ApplySuccessor(IOSet *io, const Successor *successor);
+
+// Whether appending the statements to the registers of io solves it. Leaves
+// io unchanged.
+bool Solves(IOSet *io, const vector<Successor> &statements);
+
+// Formats the first `length` statements of a program, one per line, as
+//  %k <- op %i %j
+string FormatProgram(const vector<const Successor *> &program, int length, int num_inputs);
+
+
 class SuccessorIterator {
   /*
    * SuccessorIterator stores the logic of how to traverse the search tree.
    * It knows what are the valid ops to apply to a given program state,
-   * and it decides how to order them.
+   * and orders them as ranked by the RankedOpTable it was given.
    */
  public:
-  SuccessorIterator();
-  SuccessorIterator(IOSet *io);
-  SuccessorIterator(string order_filename, IOSet *io, int sort_and_add_cutoff);
-
+  SuccessorIterator(const RankedOpTable *table, IOSet *io);
   ~SuccessorIterator();
-  void InitOps();
-  void InitSuccessors();
-  void InitSuccessors(string order_filename, int sort_and_add_cutoff);
+
+  // Skips the successors that the rewrite rules of the table (see
+  // RankedOpTable::GetRewrite) show to be redundant after the program in
+  // prefix, whose statements up to this iterator's depth must be set
+  // before Init. Ops commuting with the producer of their argument are
+  // only skipped with last_depth, when the argument is the register of the
+  // statement before and no statement can follow. NULL disables the rules.
+  void SetPrefix(const vector<const Successor *> *prefix, bool last_depth);
+
+  // Orders successors by the scorer's scores at every Init; NULL restores
+  // the ranked order. Not owned.
+  void SetScorer(NodeScorer *scorer);
 
   void Init(IOSet *io);
 
   const Successor *Next();
   const Successor *Cur();
 
+  // Number of successors returned by Next() since Init. Seek(n) skips to
+  // the n-th successor, as if Next() had been called n times.
+  int Position() const;
+  void Seek(int position);
+
  protected:
   // ProgramState *ps_;
+  const RankedOpTable *table_;
   int counter_;
+  // Copy of table_->Successors(); Cur() writes the arguments into these.
   vector<Successor> successors_;
-  vector<pair<double, Successor> > scores_and_successors_;
   vector<DatumType> types_;
   vector<int> cumulative_counts_;
 
-  // TODO: distinguish between commutative and non-commutative ops
-  vector<pair<string, DatumOp1> > int_to_int_ops_;
-  vector<pair<string, DatumOp1> > arr_to_int_ops_;
-  vector<pair<string, DatumOp1> > arr_to_arr_ops_;
-  // vector<DatumOp1> int_to_arr_ops_;
-  vector<pair<string, DatumOp2> > int_arr_to_arr_ops_;
-  vector<pair<string, DatumOp2> > int_arr_to_int_ops_;
-  vector<pair<string, DatumOp2> > arr_arr_to_arr_ops_;
-  vector<pair<string, DatumOp2> > arr_int_to_arr_ops_;
+  bool Redundant(const Successor &op, int arg1, int arg2) const;
+  const vector<const Successor *> *prefix_;
+  bool last_depth_;
+  int num_inputs_;
+  // The op of each register's statement, -1 for the inputs.
+  vector<int> producer_ids_;
+
+  // Order in which successors_ and registers are tried at this node.
+  NodeScorer *scorer_;
+  vector<int> order_;
+  vector<int> arg_order_;
+  vector<double> op_scores_;
+  vector<double> register_scores_;
 };
 
 
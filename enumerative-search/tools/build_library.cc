@@ -0,0 +1,263 @@
+// Builds the program library read by `search --library=FILE`.
+//
+// For each input type signature, enumerates every program of up to
+// --max_len statements with the search's ops, runs it on fixed random probe
+// inputs and keeps the shortest program for each distinct output.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string.h>
+#include <sstream>
+#include <unordered_map>
+
+#include "utils.h"
+#include "datum.h"
+#include "io_set.h"
+#include "program_library.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include "successor.h"
+
+
+using namespace std;
+
+
+struct LibraryConfig {
+  LibraryConfig() :
+    max_length(3), num_probes(8), array_length(10), value_range(64), seed(0)
+  {}
+
+  int max_length;
+  int num_probes;
+  int array_length;
+  int value_range;
+  int seed;
+  vector<string> signatures;
+};
+
+
+static void Usage() {
+  cout << "Usage:" << endl;
+  cout << "  build_library OUTPUT_FILE [OPTIONS]" << endl;
+  cout << "Options:" << endl;
+  cout << "  --signatures=S1;S2;...  input signatures, e.g. Array;Int,Array (default" << endl;
+  cout << "                          Array;Int,Array;Array,Array)" << endl;
+  cout << "  --from=TEST_SET_NAME    add the signatures found in data/NAME/input_types.txt" << endl;
+  cout << "  --max_len=L             maximum program length, at most "
+       << ProgramLibrary::kMaxLength << " (default 3)" << endl;
+  cout << "  --probes=N              number of probe inputs (default 8)" << endl;
+  cout << "  --array_length=L        maximum length of probe arrays (default 10)" << endl;
+  cout << "  --value_range=V         probe values are drawn from [-V, V) (default 64)" << endl;
+  cout << "  --seed=S                random seed (default 0)" << endl;
+  exit(1);
+}
+
+
+static void AddSignature(LibraryConfig &config, string signature) {
+  if (find(config.signatures.begin(), config.signatures.end(), signature) == config.signatures.end()) {
+    config.signatures.push_back(signature);
+  }
+}
+
+
+static LibraryConfig ParseArgs(int argc, char *argv[]) {
+  LibraryConfig config;
+  for (int i = 2; i < argc; i++) {
+    string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == string::npos)  Usage();
+    string name = arg.substr(2, eq - 2);
+    string value = arg.substr(eq + 1);
+
+    if (name == "signatures") {
+      stringstream ss(value);
+      string signature;
+      while (getline(ss, signature, ';'))  AddSignature(config, signature);
+    } else if (name == "from") {
+      string filename = "data/" + value + "/input_types.txt";
+      ifstream f;
+      f.open(filename);
+      CHECK(f.is_open(), "Failed to open file " + filename);
+      string line;
+      while (getline(f, line)) {
+        stringstream ss(line);
+        string type, signature;
+        while (ss >> type)  signature += (signature.empty() ? "" : ",") + type;
+        if (!signature.empty())  AddSignature(config, signature);
+      }
+    } else if (name == "max_len") {
+      config.max_length = atoi(value.c_str());
+    } else if (name == "probes") {
+      config.num_probes = atoi(value.c_str());
+    } else if (name == "array_length") {
+      config.array_length = atoi(value.c_str());
+    } else if (name == "value_range") {
+      config.value_range = atoi(value.c_str());
+    } else if (name == "seed") {
+      config.seed = atoi(value.c_str());
+    } else {
+      Usage();
+    }
+  }
+  if (config.signatures.empty())  config.signatures = {"Array", "Int,Array", "Array,Array"};
+  CHECK(config.max_length >= 1 && config.max_length <= ProgramLibrary::kMaxLength,
+        "--max_len must be between 1 and " + to_string(ProgramLibrary::kMaxLength));
+  return config;
+}
+
+
+// mt19937 is specified exactly, unlike the standard distributions, so the
+// probes are the same across standard library implementations.
+static int RandomInt(mt19937 &rng, int lo, int hi) {
+  return lo + rng() % (uint32_t) (hi - lo + 1);
+}
+
+
+static vector<DatumType> ParseSignature(string signature) {
+  vector<DatumType> types;
+  stringstream ss(signature);
+  string type;
+  while (getline(ss, type, ',')) {
+    if (type == "Int")  types.push_back(Int);
+    else if (type == "Array")  types.push_back(Array);
+    else CHECK(false, "Unexpected type " + type + " in signature " + signature);
+  }
+  return types;
+}
+
+
+static IOSet *ProbeInputs(const vector<DatumType> &types, const LibraryConfig &config,
+                          mt19937 &rng) {
+  vector<ProgramState *> inputs;
+  vector<Datum *> outputs;
+  for (int i = 0; i < config.num_probes; i++) {
+    vector<Datum *> data;
+    for (auto type : types) {
+      if (type == Int) {
+        data.push_back(new Datum(RandomInt(rng, 0, config.array_length)));
+      } else {
+        vector<int> values(RandomInt(rng, 1, config.array_length));
+        for (auto &v : values)  v = RandomInt(rng, -config.value_range, config.value_range - 1);
+        data.push_back(new Datum(values));
+      }
+    }
+    inputs.push_back(new ProgramState(data));
+    // Probes have no targets; the IOSet only runs programs.
+    outputs.push_back(new Datum(0));
+  }
+  return new IOSet(inputs, outputs);
+}
+
+
+// FNV-1a over the last datum of every probe.
+static uint64_t OutputHash(IOSet *io) {
+  uint64_t hash = 14695981039346656037ULL;
+  auto mix = [&hash](uint32_t x) {
+    for (int b = 0; b < 4; b++) {
+      hash ^= (x >> (8 * b)) & 0xff;
+      hash *= 1099511628211ULL;
+    }
+  };
+  for (int i = 0; i < io->Size(); i++) {
+    Datum *d = io->GetInputs(i)->GetLastDatum();
+    mix(d->Type());
+    if (d->Type() == Int) {
+      mix(d->GetIntValue());
+    } else {
+      mix(d->Size());
+      for (int j = 0; j < d->Size(); j++)  mix(d->GetArrayElementValue(j));
+    }
+  }
+  return hash;
+}
+
+
+static vector<ProgramLibrary::Program> BuildSignature(const RankedOpTable &table,
+                                                      string signature,
+                                                      const LibraryConfig &config) {
+  mt19937 rng(config.seed);
+  IOSet *io = ProbeInputs(ParseSignature(signature), config, rng);
+
+  vector<SuccessorIterator *> iterators;
+  for (int i = 0; i < config.max_length; i++) {
+    iterators.push_back(new SuccessorIterator(&table, io));
+  }
+
+  // Depth-first enumeration as in the search, keeping the first of the
+  // shortest programs for every output hash.
+  unordered_map<uint64_t, ProgramLibrary::Program> by_hash;
+  vector<uint64_t> order;
+  ProgramLibrary::Program program;
+  memset(&program, 0, sizeof(program));
+  long num_programs = 0;
+
+  int depth = 0;
+  while (depth >= 0) {
+    const Successor *successor = iterators[depth]->Next();
+    if (successor == NULL) {
+      depth -= 1;
+      io->Pop();
+      continue;
+    }
+
+    ApplySuccessor(io, successor);
+    num_programs++;
+    ProgramLibrary::Step &step = program.steps[depth];
+    step.op_id = successor->Id();
+    step.arg1 = successor->IsOp1() ? successor->GetOp1Arg() : successor->GetOp2Arg1();
+    step.arg2 = successor->IsOp1() ? 0 : successor->GetOp2Arg2();
+    for (int j = depth + 1; j < ProgramLibrary::kMaxLength; j++) {
+      memset(&program.steps[j], 0, sizeof(program.steps[j]));
+    }
+    program.length = depth + 1;
+    uint64_t hash = OutputHash(io);
+
+    auto it = by_hash.find(hash);
+    if (it == by_hash.end()) {
+      by_hash[hash] = program;
+      order.push_back(hash);
+    } else if (it->second.length > program.length) {
+      it->second = program;
+    }
+
+    if (depth < config.max_length - 1) {
+      depth += 1;
+      iterators[depth]->Init(io);
+    } else {
+      io->Pop();
+    }
+  }
+
+  for (auto it : iterators)  delete it;
+  delete io;
+
+  // Shortest first; among equally long programs, in enumeration order.
+  vector<ProgramLibrary::Program> result;
+  for (auto hash : order)  result.push_back(by_hash[hash]);
+  stable_sort(result.begin(), result.end(),
+              [](const ProgramLibrary::Program &a, const ProgramLibrary::Program &b) {
+                return a.length < b.length;
+              });
+
+  cout << signature << ": " << num_programs << " programs, " << result.size()
+       << " distinct on " << config.num_probes << " probes" << endl;
+  return result;
+}
+
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2 || string(argv[1]).compare(0, 2, "--") == 0)  Usage();
+  string output_filename = argv[1];
+  LibraryConfig config = ParseArgs(argc, argv);
+
+  RankedOpTable table;
+  vector<vector<ProgramLibrary::Program> > programs;
+  for (auto &signature : config.signatures) {
+    programs.push_back(BuildSignature(table, signature, config));
+  }
+  ProgramLibrary::Write(output_filename, config.signatures, programs);
+}
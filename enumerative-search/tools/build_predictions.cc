@@ -0,0 +1,57 @@
+// Consolidates the per-problem prediction files data/NAME/predictions/ID.txt
+// of a dataset into the single matrix data/NAME/predictions.bin that the
+// search reads with ORDER_TYPE 1.
+
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#include "utils.h"
+#include "predictions_matrix.h"
+
+
+using namespace std;
+
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3) {
+    cout << "Usage:" << endl;
+    cout << "  build_predictions TEST_SET_NAME NUM_PROBLEMS" << endl;
+    exit(1);
+  }
+  string test_set = argv[1];
+  int num_problems = atoi(argv[2]);
+
+  // The component order of the first file fixes the column order.
+  vector<string> components;
+  vector<vector<float> > rows;
+  for (int problem_idx = 0; problem_idx < num_problems; problem_idx++) {
+    string filename = "data/" + test_set + "/predictions/" + to_string(problem_idx) + ".txt";
+    ifstream f;
+    f.open(filename);
+    CHECK(f.is_open(), "Failed to open file " + filename);
+
+    map<string, float> name_to_prob;
+    float prob;
+    string name;
+    while (f >> prob) {
+      f >> name;
+      if (problem_idx == 0)  components.push_back(name);
+      name_to_prob[name] = prob;
+    }
+
+    vector<float> row;
+    for (auto &component : components) {
+      CHECK(name_to_prob.count(component), "Missing component " + component + " in " + filename);
+      row.push_back(name_to_prob[component]);
+    }
+    CHECK_EQ(name_to_prob.size(), components.size(), "Unexpected components in " + filename);
+    rows.push_back(row);
+  }
+
+  string out_filename = "data/" + test_set + "/predictions.bin";
+  PredictionsMatrix::Write(out_filename, components, rows);
+  cout << "Wrote " << rows.size() << " x " << components.size() << " predictions to "
+       << out_filename << endl;
+}
@@ -0,0 +1,375 @@
+// Generates input-output examples for programs in the syntax of
+// generate_io_samples.py, e.g.
+//   a <- [int] | b <- int | c <- TAKE b a | d <- COUNT isEVEN c | e <- TAKE d a
+// and writes them to data/NAME/ in the layout the search reads.
+//
+// Input bounds are propagated backwards from the output as by the *_bounds
+// helpers of generate_io_samples.py. The programs are run with the kernels
+// of ops.cc, so the examples follow the search's semantics (e.g. HEAD of an
+// empty list is 0). Programs are spread over threads; every program has its
+// own random stream, so the output does not depend on --threads.
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <math.h>
+#include <random>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+
+#include "utils.h"
+#include "datum.h"
+#include "program_parser.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+#include "successor.h"
+
+
+using namespace std;
+
+
+struct GenerateConfig {
+  GenerateConfig() :
+    num_examples(5), array_length(10), value_range(512), seed(0), num_threads(0)
+  {}
+
+  int num_examples;
+  int array_length;
+  int value_range;
+  int seed;
+  int num_threads;
+};
+
+
+// Inclusive lower and exclusive upper bound of the values of a register.
+typedef pair<int, int> Bounds;
+
+struct Program {
+  ParsedProgram parsed;
+  vector<Bounds> input_bounds;
+};
+
+// Examples of one program, formatted, or why there are none.
+struct Samples {
+  vector<string> inputs;
+  vector<string> outputs;
+  string error;
+};
+
+
+static const int kMaxAttemptsPerExample = 100;
+// Programs are generated and written in batches of this many.
+static const int kBatchSize = 10000;
+
+
+static void Usage() {
+  cout << "Usage:" << endl;
+  cout << "  generate_io PROGRAMS_FILE TEST_SET_NAME [OPTIONS]" << endl;
+  cout << "PROGRAMS_FILE holds one program per line, with statements separated by |." << endl;
+  cout << "Options:" << endl;
+  cout << "  --examples=N          examples per program (default 5)" << endl;
+  cout << "  --array_length=L      length of input arrays (default 10)" << endl;
+  cout << "  --value_range=V       values of inputs and outputs lie in [-V, V] (default 512)" << endl;
+  cout << "  --seed=S              random seed (default 0)" << endl;
+  cout << "  --threads=T           generating threads (default: one per core)" << endl;
+  exit(1);
+}
+
+
+static GenerateConfig ParseArgs(int argc, char *argv[]) {
+  GenerateConfig config;
+  for (int i = 3; i < argc; i++) {
+    string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == string::npos)  Usage();
+    string name = arg.substr(2, eq - 2);
+    string value = arg.substr(eq + 1);
+
+    if (name == "examples") {
+      config.num_examples = atoi(value.c_str());
+    } else if (name == "array_length") {
+      config.array_length = atoi(value.c_str());
+    } else if (name == "value_range") {
+      config.value_range = atoi(value.c_str());
+    } else if (name == "seed") {
+      config.seed = atoi(value.c_str());
+    } else if (name == "threads") {
+      config.num_threads = atoi(value.c_str());
+    } else {
+      Usage();
+    }
+  }
+  CHECK(config.num_examples >= 1 && config.array_length >= 1 && config.value_range >= 1,
+        "--examples, --array_length and --value_range must be positive");
+  if (config.num_threads <= 0)  config.num_threads = max((int) thread::hardware_concurrency(), 1);
+  return config;
+}
+
+
+/*
+ *
+ * Bounds
+ *
+ */
+
+// Division rounding down, as Python's integer division.
+static int FloorDiv(int a, int b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+
+static Bounds SqrBounds(int A, int B) {
+  int l = max(0, A);
+  int u = B - 1;
+  if (l > u)  return Bounds(0, 0);
+  return Bounds(-(int) sqrt(u), (int) ceil(sqrt(u + 1)));
+}
+
+
+// Bounds of the argument of a lambda given the bounds of its result.
+static Bounds LambdaBounds(string lambda, Bounds result) {
+  int A = result.first, B = result.second;
+  if (lambda == "INC")  return Bounds(A, B - 1);
+  if (lambda == "DEC")  return Bounds(A + 1, B);
+  if (lambda == "SHL")  return Bounds(FloorDiv(A + 1, 2), FloorDiv(B, 2));
+  if (lambda == "SHR")  return Bounds(2 * A, 2 * B);
+  if (lambda == "doNEG")  return Bounds(-B + 1, -A + 1);
+  if (lambda == "MUL3")  return Bounds(FloorDiv(A + 2, 3), FloorDiv(B, 3));
+  if (lambda == "MUL4")  return Bounds(FloorDiv(A + 3, 4), FloorDiv(B, 4));
+  if (lambda == "SQR")  return SqrBounds(A, B);
+  if (lambda == "+" || lambda == "-")  return Bounds(FloorDiv(A, 2) + 1, FloorDiv(B, 2));
+  if (lambda == "*")  return SqrBounds(0, min(-(A + 1), B));
+  return result;  // DIV3, DIV4, predicates, MIN, MAX
+}
+
+
+static Bounds ScanlBounds(string lambda, Bounds result, int L) {
+  int A = result.first, B = result.second;
+  if (lambda == "+" || lambda == "-")  return Bounds(FloorDiv(A, L) + 1, FloorDiv(B, L));
+  if (lambda == "*") {
+    return Bounds((int) pow(max(0, A) + 1, 1.0 / L), (int) pow(max(0, B), 1.0 / L));
+  }
+  return result;  // MIN, MAX
+}
+
+
+static vector<int> Args(const Successor &statement) {
+  if (statement.IsOp1())  return vector<int>({statement.GetOp1Arg()});
+  return vector<int>({statement.GetOp2Arg1(), statement.GetOp2Arg2()});
+}
+
+
+// Bounds of the arguments of a statement given the bounds of its result.
+static vector<Bounds> ArgumentBounds(const Successor &statement, Bounds result,
+                                     const GenerateConfig &config) {
+  int A = result.first, B = result.second, L = config.array_length;
+  string command = DslName(statement.Name());
+  size_t space = command.find(' ');
+  string function = command.substr(0, space);
+  string lambda = space == string::npos ? "" : command.substr(space + 1);
+
+  if (function == "TAKE" || function == "DROP" || function == "ACCESS") {
+    return vector<Bounds>({Bounds(0, L), result});
+  }
+  if (function == "SUM")  return vector<Bounds>({Bounds(FloorDiv(A, L) + 1, FloorDiv(B, L))});
+  if (function == "MAP")  return vector<Bounds>({LambdaBounds(lambda, result)});
+  if (function == "COUNT") {
+    return vector<Bounds>({Bounds(-config.value_range, config.value_range)});
+  }
+  if (function == "ZIPWITH")  return vector<Bounds>(2, LambdaBounds(lambda, result));
+  if (function == "SCANL1")  return vector<Bounds>({ScanlBounds(lambda, result, L)});
+  return vector<Bounds>({result});  // REVERSE, SORT, HEAD, LAST, MINIMUM, MAXIMUM, FILTER
+}
+
+
+// Narrows every register from [-V, V) to the values that keep the later
+// statements in range, and returns false if an input is left without any.
+static bool PropagateBounds(Program *program, const GenerateConfig &config) {
+  int num_inputs = program->parsed.input_types.size();
+  vector<Bounds> bounds(num_inputs + program->parsed.statements.size(),
+                        Bounds(-config.value_range, config.value_range));
+  for (int t = bounds.size() - 1; t >= num_inputs; t--) {
+    const Successor &statement = program->parsed.statements[t - num_inputs];
+    vector<Bounds> arg_bounds = ArgumentBounds(statement, bounds[t], config);
+    vector<int> args = Args(statement);
+    for (int a = 0; a < args.size(); a++) {
+      Bounds &b = bounds[args[a]];
+      b = Bounds(max(b.first, arg_bounds[a].first), min(b.second, arg_bounds[a].second));
+    }
+  }
+  program->input_bounds.assign(bounds.begin(), bounds.begin() + num_inputs);
+  for (auto &b : program->input_bounds) {
+    if (b.second <= b.first)  return false;
+  }
+  return true;
+}
+
+
+/*
+ *
+ * Sampling
+ *
+ */
+
+// mt19937 is specified exactly, unlike the standard distributions, so the
+// examples are the same across standard library implementations.
+static int RandomInt(mt19937 &rng, int lo, int hi) {
+  return lo + rng() % (uint32_t) (hi - lo + 1);
+}
+
+
+static string FormatDatum(Datum *d) {
+  stringstream ss;
+  if (d->Type() == Int) {
+    ss << d->GetIntValue();
+  } else {
+    for (int i = 0; i < d->Size(); i++)  ss << (i > 0 ? " " : "") << d->GetArrayElementValue(i);
+  }
+  return ss.str();
+}
+
+
+static bool InRange(Datum *d, int value_range) {
+  if (d->Type() == Int)  return abs(d->GetIntValue()) <= value_range;
+  for (int i = 0; i < d->Size(); i++) {
+    if (abs(d->GetArrayElementValue(i)) > value_range)  return false;
+  }
+  return true;
+}
+
+
+static void Sample(const Program &program, int line_number, const GenerateConfig &config,
+                   Samples *samples) {
+  const vector<DatumType> &input_types = program.parsed.input_types;
+  mt19937 rng((uint32_t) config.seed * 1000003u + line_number);
+  for (int e = 0; e < config.num_examples; e++) {
+    bool accepted = false;
+    for (int attempt = 0; attempt < kMaxAttemptsPerExample && !accepted; attempt++) {
+      vector<Datum *> inputs;
+      for (int j = 0; j < input_types.size(); j++) {
+        int lo = program.input_bounds[j].first, hi = program.input_bounds[j].second - 1;
+        if (input_types[j] == Int) {
+          inputs.push_back(new Datum(RandomInt(rng, lo, hi)));
+        } else {
+          vector<int> values(config.array_length);
+          for (auto &v : values)  v = RandomInt(rng, lo, hi);
+          inputs.push_back(new Datum(values));
+        }
+      }
+      ProgramState ps(inputs);
+      RunProgram(program.parsed, &ps);
+
+      // The bounds are heuristic for some functions (e.g. ACCESS of a
+      // filtered list), so outputs are checked as well. Like
+      // generate_io_samples.py, which gives Null there, examples where a
+      // statement is undefined (e.g. HEAD of an empty list) are redrawn.
+      accepted = ps.GetLastDatum()->Defined() && InRange(ps.GetLastDatum(), config.value_range);
+      if (accepted) {
+        string input;
+        for (int j = 0; j < input_types.size(); j++) {
+          input += (j > 0 ? " | " : "") + FormatDatum(ps.GetDatum(j));
+        }
+        samples->inputs.push_back(input);
+        samples->outputs.push_back(FormatDatum(ps.GetLastDatum()));
+      }
+    }
+    if (!accepted) {
+      samples->error = "no defined output within the value range after " +
+        to_string(kMaxAttemptsPerExample) + " attempts";
+      return;
+    }
+  }
+}
+
+
+static string TypeName(DatumType type) {
+  return type == Int ? "Int" : "Array";
+}
+
+
+int main(int argc, char *argv[])
+{
+  if (argc < 3)  Usage();
+  string programs_filename = argv[1];
+  string dir = string("data/") + argv[2];
+  GenerateConfig config = ParseArgs(argc, argv);
+
+  ifstream programs_file(programs_filename);
+  CHECK(programs_file.is_open(), "Failed to open file " + programs_filename);
+  mkdir(dir.c_str(), 0755);
+  ofstream input_types(dir + "/input_types.txt");
+  ofstream input_values(dir + "/input_values.txt");
+  ofstream output_types(dir + "/output_types.txt");
+  ofstream output_values(dir + "/output_values.txt");
+  ofstream programs_out(dir + "/programs.txt");
+  CHECK(input_types.is_open() && input_values.is_open() && output_types.is_open() &&
+        output_values.is_open() && programs_out.is_open(), "Failed to create files in " + dir);
+
+  RankedOpTable table;
+  int num_read = 0, num_programs = 0, num_written = 0;
+  bool more = true;
+  while (more) {
+    vector<Program> programs;
+    vector<int> line_numbers;
+    string line;
+    while (programs.size() < kBatchSize && (more = (bool) getline(programs_file, line))) {
+      num_read++;
+      if (line.find_first_not_of(" \t\r") == string::npos)  continue;
+      num_programs++;
+      Program program;
+      string error;
+      if (!ParseProgram(table, line, vector<DatumType>(), &program.parsed, &error)) {
+        cerr << "Line " << num_read << ": " << error << endl;
+      } else if (!PropagateBounds(&program, config)) {
+        cerr << "Line " << num_read << ": program with no valid inputs" << endl;
+      } else {
+        programs.push_back(program);
+        line_numbers.push_back(num_read);
+      }
+    }
+
+    vector<Samples> samples(programs.size());
+    atomic<int> next(0);
+    vector<thread> threads;
+    for (int i = 0; i < config.num_threads; i++) {
+      threads.push_back(thread([&]() {
+        for (int p = next++; p < programs.size(); p = next++) {
+          Sample(programs[p], line_numbers[p], config, &samples[p]);
+        }
+      }));
+    }
+    for (auto &t : threads)  t.join();
+
+    // Lines are not flushed one by one, which would dominate the run time.
+    for (int p = 0; p < programs.size(); p++) {
+      if (!samples[p].error.empty()) {
+        cerr << "Line " << line_numbers[p] << ": " << samples[p].error << endl;
+        continue;
+      }
+      const ParsedProgram &program = programs[p].parsed;
+      for (int j = 0; j < program.input_types.size(); j++) {
+        input_types << (j > 0 ? " " : "") << TypeName(program.input_types[j]);
+      }
+      input_types << '\n';
+      output_types << TypeName(program.statements.back().ResultType()) << '\n';
+      for (int e = 0; e < config.num_examples; e++) {
+        input_values << samples[p].inputs[e] << '\n';
+        output_values << samples[p].outputs[e] << '\n';
+      }
+
+      // Ground truth in the search's output syntax, statements separated by " | ".
+      int num_inputs = program.input_types.size();
+      for (int s = 0; s < program.statements.size(); s++) {
+        const Successor &statement = program.statements[s];
+        programs_out << (s > 0 ? " | " : "") << "%" << num_inputs + s << " <- " << statement.Name();
+        for (int arg : Args(statement))  programs_out << " %" << arg;
+      }
+      programs_out << '\n';
+      num_written++;
+    }
+  }
+
+  cout << "Wrote " << num_written << " of " << num_programs << " programs with " << config.num_examples
+       << " examples each to " << dir << endl;
+}
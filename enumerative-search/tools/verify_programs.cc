@@ -0,0 +1,213 @@
+// Runs programs on the examples of a data set and reports the share of
+// examples each one gets right. Line i of the programs file is checked
+// against problem i of data/NAME, e.g. the ground truth of tools/generate_io
+// (programs.txt) or the solutions of a search, in the search's syntax with
+// statements separated by |, against held-out examples:
+//   %2 <- sort %1 | %3 <- arr_head %1 | %4 <- access %3 %2
+// Programs in the syntax of generate_io_samples.py are read as well.
+//
+// The examples of a batch of problems are split into chunks, which threads
+// parse and run with the kernels of ops.cc, so that problems with many
+// examples are spread over all threads too.
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "utils.h"
+#include "datum.h"
+#include "io_set.h"
+#include "program_parser.h"
+#include "program_state.h"
+#include "ranked_op_table.h"
+
+
+using namespace std;
+
+
+struct VerifyConfig {
+  VerifyConfig() :
+    num_examples(5), num_threads(0)
+  {}
+
+  int num_examples;
+  int num_threads;
+};
+
+
+// A program and the examples of its problem, as read from the files.
+struct Problem {
+  int line_number;
+  ParsedProgram program;
+  DatumType output_type;
+  vector<string> inputs;
+  vector<string> outputs;
+  string error;
+};
+
+// Examples [begin, end) of a problem.
+struct Chunk {
+  int problem;
+  int begin;
+  int end;
+};
+
+
+static const int kChunkSize = 1024;
+// Problems are read and checked in batches of at most this many examples.
+static const int kBatchExamples = 1 << 18;
+
+
+static void Usage() {
+  cout << "Usage:" << endl;
+  cout << "  verify_programs PROGRAMS_FILE TEST_SET_NAME [OPTIONS]" << endl;
+  cout << "Line i of PROGRAMS_FILE is the program of problem i of data/TEST_SET_NAME." << endl;
+  cout << "Options:" << endl;
+  cout << "  --examples=N          examples per problem in the data set (default 5)" << endl;
+  cout << "  --threads=T           checking threads (default: one per core)" << endl;
+  exit(1);
+}
+
+
+static VerifyConfig ParseArgs(int argc, char *argv[]) {
+  VerifyConfig config;
+  for (int i = 3; i < argc; i++) {
+    string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == string::npos)  Usage();
+    string name = arg.substr(2, eq - 2);
+    string value = arg.substr(eq + 1);
+
+    if (name == "examples") {
+      config.num_examples = atoi(value.c_str());
+    } else if (name == "threads") {
+      config.num_threads = atoi(value.c_str());
+    } else {
+      Usage();
+    }
+  }
+  CHECK(config.num_examples >= 1, "--examples must be positive");
+  if (config.num_threads <= 0)  config.num_threads = max((int) thread::hardware_concurrency(), 1);
+  return config;
+}
+
+
+// Reads the next problem of the data set and parses its program.
+static void ReadProblem(const RankedOpTable &table, const string &source, ifstream &input_types,
+                        ifstream &input_values, ifstream &output_types, ifstream &output_values,
+                        int num_examples, Problem *problem) {
+  string line;
+  vector<DatumType> types, result_types;
+  CHECK(getline(input_types, line), "The data set has fewer problems than programs");
+  CHECK(IOSet::ParseTypes(line, types), "Unexpected input types in " + line);
+  CHECK(getline(output_types, line) && IOSet::ParseTypes(line, result_types) &&
+        result_types.size() == 1, "Unexpected output type in " + line);
+  problem->output_type = result_types[0];
+  for (int e = 0; e < num_examples; e++) {
+    problem->inputs.push_back("");
+    problem->outputs.push_back("");
+    CHECK(getline(input_values, problem->inputs.back()) &&
+          getline(output_values, problem->outputs.back()),
+          "The data set has fewer examples than programs");
+  }
+
+  if (source.find_first_not_of(" \t\r") == string::npos) {
+    problem->error = "no program";
+  } else if (ParseProgram(table, source, types, &problem->program, &problem->error) &&
+             problem->program.statements.back().ResultType() != problem->output_type) {
+    problem->error = "the result does not have the type of the outputs";
+  }
+}
+
+
+// The number of examples of the chunk the program gets right.
+static int Verify(const Problem &problem, const Chunk &chunk) {
+  vector<DatumType> output_types(1, problem.output_type);
+  int num_passed = 0;
+  for (int e = chunk.begin; e < chunk.end; e++) {
+    ProgramState *ps = IOSet::ParseValues(problem.inputs[e], problem.program.input_types);
+    ProgramState *output = IOSet::ParseValues(problem.outputs[e], output_types);
+    CHECK(ps != NULL && output != NULL, "inconsistency in values and types data");
+    RunProgram(problem.program, ps);
+    num_passed += *ps->GetLastDatum() == *output->GetDatum(0);
+    delete ps;
+    delete output;
+  }
+  return num_passed;
+}
+
+
+int main(int argc, char *argv[])
+{
+  if (argc < 3)  Usage();
+  string programs_filename = argv[1];
+  string dir = string("data/") + argv[2];
+  VerifyConfig config = ParseArgs(argc, argv);
+
+  ifstream programs_file(programs_filename);
+  CHECK(programs_file.is_open(), "Failed to open file " + programs_filename);
+  ifstream input_types(dir + "/input_types.txt");
+  ifstream input_values(dir + "/input_values.txt");
+  ifstream output_types(dir + "/output_types.txt");
+  ifstream output_values(dir + "/output_values.txt");
+  CHECK(input_types.is_open() && input_values.is_open() && output_types.is_open() &&
+        output_values.is_open(), "Failed to open the data files in " + dir);
+
+  RankedOpTable table;
+  int num_programs = 0, num_correct = 0, num_errors = 0;
+  double total_rate = 0;
+  bool more = true;
+  while (more) {
+    vector<Problem> problems;
+    string line;
+    while (problems.size() * config.num_examples < kBatchExamples &&
+           (more = (bool) getline(programs_file, line))) {
+      problems.push_back(Problem());
+      problems.back().line_number = ++num_programs;
+      ReadProblem(table, line, input_types, input_values, output_types, output_values,
+                  config.num_examples, &problems.back());
+    }
+
+    vector<Chunk> chunks;
+    for (int p = 0; p < problems.size(); p++) {
+      if (!problems[p].error.empty())  continue;
+      for (int begin = 0; begin < config.num_examples; begin += kChunkSize) {
+        chunks.push_back({p, begin, min(begin + kChunkSize, config.num_examples)});
+      }
+    }
+    vector<int> chunk_passed(chunks.size());
+    atomic<int> next(0);
+    vector<thread> threads;
+    for (int i = 0; i < config.num_threads; i++) {
+      threads.push_back(thread([&]() {
+        for (int c = next++; c < chunks.size(); c = next++) {
+          chunk_passed[c] = Verify(problems[chunks[c].problem], chunks[c]);
+        }
+      }));
+    }
+    for (auto &t : threads)  t.join();
+
+    vector<int> num_passed(problems.size(), 0);
+    for (int c = 0; c < chunks.size(); c++)  num_passed[chunks[c].problem] += chunk_passed[c];
+    for (int p = 0; p < problems.size(); p++) {
+      cout << "Program " << problems[p].line_number << ": ";
+      if (!problems[p].error.empty()) {
+        cout << problems[p].error << '\n';
+        num_errors++;
+        continue;
+      }
+      double rate = num_passed[p] / (double) config.num_examples;
+      cout << num_passed[p] << " of " << config.num_examples << " examples (" << fixed
+           << setprecision(2) << 100 * rate << "%)" << '\n';
+      total_rate += rate;
+      num_correct += num_passed[p] == config.num_examples;
+    }
+  }
+
+  cout << num_correct << " of " << num_programs << " programs pass every example";
+  if (num_errors > 0)  cout << ", " << num_errors << " could not be checked";
+  cout << "; mean pass rate " << fixed << setprecision(2)
+       << 100 * total_rate / max(num_programs - num_errors, 1) << "%" << endl;
+}